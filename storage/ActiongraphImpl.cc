@@ -27,7 +27,15 @@
 #include <boost/graph/graph_utility.hpp>
 #include <boost/graph/graphviz.hpp>
 
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 #include "storage/Utils/Stopwatch.h"
+#include "storage/Utils/LibraryLock.h"
+#include "storage/Utils/LoggerImpl.h"
+#include "storage/Utils/Remote.h"
 #include "storage/Utils/CallbacksImpl.h"
 #include "storage/Devices/DeviceImpl.h"
 #include "storage/Devices/BlkDevice.h"
@@ -53,8 +61,8 @@
 namespace storage
 {
 
-    CommitData::CommitData(const Actiongraph::Impl& actiongraph, Tense tense)
-	: actiongraph(actiongraph), tense(tense)
+    CommitData::CommitData(const Actiongraph::Impl& actiongraph, Tense tense, bool defer_config_files)
+	: actiongraph(actiongraph), tense(tense), defer_config_files(defer_config_files)
     {
     }
 
@@ -73,6 +81,7 @@ namespace storage
 	    string filename = storage.get_impl().prepend_rootprefix(ETC_FSTAB);
 
 	    etc_fstab.reset(new EtcFstab(filename));
+	    etc_fstab->set_replace(defer_config_files);
 	}
 
 	return *etc_fstab.get();
@@ -88,6 +97,7 @@ namespace storage
 	    string filename = storage.get_impl().prepend_rootprefix(ETC_CRYPTTAB);
 
 	    etc_crypttab.reset(new EtcCrypttab(filename));
+	    etc_crypttab->set_replace(defer_config_files);
 	}
 
 	return *etc_crypttab.get();
@@ -103,12 +113,64 @@ namespace storage
 	    string filename = storage.get_impl().prepend_rootprefix(ETC_MDADM);
 
 	    etc_mdadm.reset(new EtcMdadm(filename));
+	    etc_mdadm->set_auto_save(!defer_config_files);
+	    etc_mdadm->set_replace(defer_config_files);
 	}
 
 	return *etc_mdadm.get();
     }
 
 
+    void
+    CommitData::write_etc_fstab()
+    {
+	if (defer_config_files)
+	{
+	    etc_fstab_modified = true;
+	    return;
+	}
+
+	etc_fstab->log_diff();
+	etc_fstab->write();
+    }
+
+
+    void
+    CommitData::write_etc_crypttab()
+    {
+	if (defer_config_files)
+	{
+	    etc_crypttab_modified = true;
+	    return;
+	}
+
+	etc_crypttab->log();
+	etc_crypttab->write();
+    }
+
+
+    void
+    CommitData::write_config_files()
+    {
+	if (etc_fstab_modified)
+	{
+	    etc_fstab->log_diff();
+	    etc_fstab->write();
+	    etc_fstab_modified = false;
+	}
+
+	if (etc_crypttab_modified)
+	{
+	    etc_crypttab->log();
+	    etc_crypttab->write();
+	    etc_crypttab_modified = false;
+	}
+
+	if (etc_mdadm)
+	    etc_mdadm->write();
+    }
+
+
     class CheckCallbacksLogger : public CheckCallbacks
     {
     public:
@@ -213,7 +275,56 @@ namespace storage
     Actiongraph::Impl::vertex_descriptor
     Actiongraph::Impl::add_vertex(Action::Base* action)
     {
-	return boost::add_vertex(shared_ptr<Action::Base>(action), graph);
+	vertex_descriptor vertex = boost::add_vertex(shared_ptr<Action::Base>(action), graph);
+
+	if (typed_actions_valid)
+	    add_to_typed_actions(vertex);
+
+	return vertex;
+    }
+
+
+    void
+    Actiongraph::Impl::add_to_typed_actions(vertex_descriptor vertex) const
+    {
+	const Action::Base* action = graph[vertex].get();
+
+	// Delete actions and some others, e.g. unmount of deleted mount
+	// points, only have the device in the LHS.
+
+	const Device* device = nullptr;
+	if (rhs->device_exists(action->sid))
+	    device = rhs->find_device(action->sid);
+	else if (lhs->device_exists(action->sid))
+	    device = lhs->find_device(action->sid);
+
+	std::pair<std::type_index, std::type_index> key(typeid(*action), device ? typeid(*device) :
+							typeid(void));
+
+	std::pair<decltype(typed_actions_index)::iterator, bool> tmp =
+	    typed_actions_index.emplace(key, typed_actions.size());
+	if (tmp.second)
+	    typed_actions.push_back({ action, device, {} });
+
+	typed_actions[tmp.first->second].vertices.push_back(vertex);
+    }
+
+
+    const vector<Actiongraph::Impl::TypedActions>&
+    Actiongraph::Impl::get_typed_actions() const
+    {
+	if (!typed_actions_valid)
+	{
+	    typed_actions.clear();
+	    typed_actions_index.clear();
+
+	    for (vertex_descriptor vertex : vertices())
+		add_to_typed_actions(vertex);
+
+	    typed_actions_valid = true;
+	}
+
+	return typed_actions;
     }
 
 
@@ -283,7 +394,7 @@ namespace storage
     const vector<Actiongraph::Impl::vertex_descriptor>&
     Actiongraph::Impl::actions_with_sid(sid_t sid) const
     {
-	map<sid_t, vector<vertex_descriptor>>::const_iterator it = cache_for_actions_with_sid.find(sid);
+	std::unordered_map<sid_t, vector<vertex_descriptor>>::const_iterator it = cache_for_actions_with_sid.find(sid);
 	if (it != cache_for_actions_with_sid.end())
 	    return it->second;
 
@@ -391,25 +502,31 @@ namespace storage
     void
     Actiongraph::Impl::remove_duplicates()
     {
-	vector<pair<vertex_descriptor, vertex_descriptor>> duplicates;
+	// The first mount and unmount action for every sid. Duplicates are
+	// merged into these.
 
-	boost::iterator_range<vertex_iterator> range = vertices();
+	unordered_map<sid_t, vertex_descriptor> first_mounts;
+	unordered_map<sid_t, vertex_descriptor> first_unmounts;
+
+	vector<pair<vertex_descriptor, vertex_descriptor>> duplicates;
 
-	for (vertex_iterator it1 = range.begin(); it1 != range.end(); ++it1)
+	for (vertex_descriptor vertex : vertices())
 	{
-	    const Action::Base* action1 = graph[*it1].get();
+	    const Action::Base* action = graph[vertex].get();
 
-	    for (vertex_iterator it2 = next(it1); it2 != range.end(); ++it2)
-	    {
-		const Action::Base* action2 = graph[*it2].get();
+	    unordered_map<sid_t, vertex_descriptor>* firsts = nullptr;
 
-		if (action1->sid == action2->sid)
-		{
-		    if ((is_mount(action1) && is_mount(action2)) ||
-			(is_unmount(action1) && is_unmount(action2)))
-			duplicates.push_back(make_pair(*it1, *it2));
-		}
-	    }
+	    if (is_mount(action))
+		firsts = &first_mounts;
+	    else if (is_unmount(action))
+		firsts = &first_unmounts;
+	    else
+		continue;
+
+	    pair<unordered_map<sid_t, vertex_descriptor>::iterator, bool> tmp =
+		firsts->emplace(action->sid, vertex);
+	    if (!tmp.second)
+		duplicates.push_back(make_pair(tmp.first->second, vertex));
 	}
 
 	for (pair<vertex_descriptor, vertex_descriptor> duplicate : duplicates)
@@ -423,6 +540,9 @@ namespace storage
 	    clear_vertex(duplicate.second, graph);
 	    remove_vertex(duplicate.second, graph);
 	}
+
+	if (!duplicates.empty())
+	    typed_actions_valid = false;
     }
 
 
@@ -432,6 +552,7 @@ namespace storage
 	boost::iterator_range<vertex_iterator> range = vertices();
 
 	mount_root_filesystem = range.end();
+	unmount_root_filesystem = range.end();
 
 	for (vertex_iterator it = range.begin(); it != range.end(); ++it)
 	{
@@ -441,6 +562,13 @@ namespace storage
 	    if (mount && mount->get_path(*this) == "/")
 		mount_root_filesystem = it;
 
+	    const Action::Unmount* unmount = dynamic_cast<const Action::Unmount*>(action);
+	    if (unmount && to_mount_point(unmount->get_device(*this))->get_path() == "/")
+		unmount_root_filesystem = it;
+
+	    if (action->only_sync)
+		only_sync_actions.push_back(*it);
+
 	    cache_for_actions_with_sid[action->sid].push_back(*it);
 	}
     }
@@ -449,8 +577,6 @@ namespace storage
     void
     Actiongraph::Impl::add_dependencies()
     {
-	vector<vertex_descriptor> mounts;
-
 	// TODO also for Devices only in LHS?
 
 	const Devicegraph* devicegraph = get_devicegraph(RHS);
@@ -467,24 +593,35 @@ namespace storage
 	Bcache::Impl::run_dependency_manager(*this);
 
 	for (vertex_descriptor vertex : vertices())
-	{
 	    graph[vertex]->add_dependencies(vertex, *this);
 
-	    const Action::Mount* mount = dynamic_cast<const Action::Mount*>(graph[vertex].get());
-	    if (mount && mount->get_path(*this) != "swap")
-		mounts.push_back(vertex);
+	// The paths are looked up once instead of in every comparison.
+
+	vector<pair<string, vertex_descriptor>> mounts;
+
+	for (vertex_descriptor vertex : actions_of_type<Action::Mount>())
+	{
+	    const Action::Mount* mount = static_cast<const Action::Mount*>(graph[vertex].get());
+
+	    const string& path = mount->get_path(*this);
+	    if (path != "swap")
+		mounts.emplace_back(path, vertex);
 	}
 
 	if (mounts.size() > 1)
 	{
 	    // TODO correct sort
-	    sort(mounts.begin(), mounts.end(), [this, &mounts](vertex_descriptor l, vertex_descriptor r) {
-		const Action::Mount* ml = dynamic_cast<const Action::Mount*>(graph[l].get());
-		const Action::Mount* mr = dynamic_cast<const Action::Mount*>(graph[r].get());
-		return ml->get_path(*this) <= mr->get_path(*this);
+	    stable_sort(mounts.begin(), mounts.end(), [](const pair<string, vertex_descriptor>& l,
+							 const pair<string, vertex_descriptor>& r) {
+		return l.first < r.first;
 	    });
 
-	    add_chain(mounts);
+	    vector<vertex_descriptor> tmp;
+	    tmp.reserve(mounts.size());
+	    for (const pair<string, vertex_descriptor>& mount : mounts)
+		tmp.push_back(mount.second);
+
+	    add_chain(tmp);
 	}
 
 	add_special_dasd_pt_dependencies();
@@ -504,11 +641,12 @@ namespace storage
 	// TODO Equivalent for all actions that use/unuse a partition. Or find
 	// a better solution.
 
-	for (vertex_descriptor vertex : vertices())
+	if (last_action_on_partition_table.empty())
+	    return;
+
+	for (vertex_descriptor vertex : actions_of_type<Action::Mount>())
 	{
-	    const Action::Mount* mount = dynamic_cast<const Action::Mount*>(graph[vertex].get());
-	    if (!mount)
-		continue;
+	    const Action::Mount* mount = static_cast<const Action::Mount*>(graph[vertex].get());
 
 	    const MountPoint* mount_point = mount->get_mount_point(*this);
 	    if (!mount_point->has_mountable())
@@ -548,15 +686,7 @@ namespace storage
     void
     Actiongraph::Impl::remove_only_syncs()
     {
-	vector<vertex_descriptor> only_syncs;
-
-	for (vertex_descriptor vertex : vertices())
-	{
-	    if ((*this)[vertex]->only_sync)
-		only_syncs.push_back(vertex);
-	}
-
-	for (vertex_descriptor vertex : only_syncs)
+	for (vertex_descriptor vertex : only_sync_actions)
 	{
 	    for (vertex_descriptor parent : parents(vertex))
 		for (vertex_descriptor child : children(vertex))
@@ -565,6 +695,11 @@ namespace storage
 	    clear_vertex(vertex, graph);
 	    remove_vertex(vertex, graph);
 	}
+
+	if (!only_sync_actions.empty())
+	    typed_actions_valid = false;
+
+	only_sync_actions.clear();
     }
 
 
@@ -621,8 +756,62 @@ namespace storage
     {
 	y2mil("commit begin");
 
-	CommitData commit_data(*this, Tense::PRESENT_CONTINUOUS);
+	CommitData commit_data(*this, Tense::PRESENT_CONTINUOUS, commit_options.defer_config_files);
+
+	try
+	{
+	    if (commit_options.max_parallel_actions > 1 && is_parallel_commit_possible())
+		commit_parallel(commit_data, commit_options, commit_callbacks);
+	    else
+		commit_serial(commit_data, commit_options, commit_callbacks);
+	}
+	catch (...)
+	{
+	    // Write the changes of the already committed actions anyway.
+
+	    try
+	    {
+		commit_data.write_config_files();
+	    }
+	    catch (const Exception& exception)
+	    {
+		ST_CAUGHT(exception);
+	    }
+
+	    throw;
+	}
+
+	commit_data.write_config_files();
+
+	y2mil("commit end");
+    }
+
+
+    bool
+    Actiongraph::Impl::is_parallel_commit_possible() const
+    {
+	// The actions log and may run commands via the remote callbacks
+	// from the worker threads. Other loggers and the remote callbacks
+	// may be implemented in the bindings which must not be called from
+	// other threads.
+
+	const Logger* logger = get_logger();
+
+	if ((logger && !is_library_logger(logger)) || get_remote_callbacks())
+	{
+	    y2mil("committing actions one after another since a custom logger or remote "
+		  "callbacks are used");
+	    return false;
+	}
+
+	return true;
+    }
 
+
+    void
+    Actiongraph::Impl::commit_serial(CommitData& commit_data, const CommitOptions& commit_options,
+				     const CommitCallbacks* commit_callbacks) const
+    {
 	for (const vertex_descriptor& vertex : order)
 	{
 	    const Action::Base* action = graph[vertex].get();
@@ -636,6 +825,9 @@ namespace storage
 	    if (action->nop)
 		continue;
 
+	    if (is_config_files_barrier(vertex))
+		commit_data.write_config_files();
+
 	    try
 	    {
 		action->commit(commit_data, commit_options);
@@ -645,8 +837,236 @@ namespace storage
 		error_callback(commit_callbacks, text, exception);
 	    }
 	}
+    }
 
-	y2mil("commit end");
+
+    bool
+    Actiongraph::Impl::is_config_files_barrier(vertex_descriptor vertex) const
+    {
+	// Mounting or unmounting the root filesystem changes where the
+	// config files below the rootprefix are written to.
+
+	boost::iterator_range<vertex_iterator> range = vertices();
+
+	return (mount_root_filesystem != range.end() && *mount_root_filesystem == vertex) ||
+	    (unmount_root_filesystem != range.end() && *unmount_root_filesystem == vertex);
+    }
+
+
+    void
+    Actiongraph::Impl::commit_parallel(CommitData& commit_data, const CommitOptions& commit_options,
+				       const CommitCallbacks* commit_callbacks) const
+    {
+	// Library code is serialized by the library lock. Worker threads only
+	// run concurrently while they wait for external programs or devices.
+	// All callbacks are called from this thread.
+
+	struct Result
+	{
+	    vertex_descriptor vertex;
+	    exception_ptr exception;
+	};
+
+	mutex results_mutex;
+	condition_variable results_cv;
+	vector<Result> results;
+
+	map<vertex_descriptor, size_t> pending_parents;
+	for (const vertex_descriptor& vertex : order)
+	    pending_parents[vertex] = in_degree(vertex, graph);
+
+	list<vertex_descriptor> waiting(order.begin(), order.end());
+	set<vertex_descriptor> failed;
+	set<sid_t> running_sids;
+	map<vertex_descriptor, thread> running;
+
+	exception_ptr abort_exception;
+
+	LibraryLock::Guard guard;
+
+	// If anything throws while scheduling, wait for the running actions
+	// before propagating the exception. Destroying joinable threads would
+	// call std::terminate.
+
+	struct RunningJoiner
+	{
+	    map<vertex_descriptor, thread>& running;
+
+	    ~RunningJoiner()
+	    {
+		LibraryLock::Unlock unlock;
+
+		for (map<vertex_descriptor, thread>::value_type& value : running)
+		{
+		    if (value.second.joinable())
+			value.second.join();
+		}
+	    }
+	};
+
+	RunningJoiner running_joiner { running };
+
+	// Marks an action as finished and skips the actions depending on a
+	// failed action.
+
+	auto finish = [&](vertex_descriptor vertex, bool ok) {
+
+	    for (vertex_descriptor child : children(vertex))
+	    {
+		if (!ok && failed.insert(child).second)
+		    y2war("skipping action \"" << graph[child]->text(commit_data).native << "\" since "
+			  "a previous action failed");
+
+		--pending_parents[child];
+	    }
+	};
+
+	while (!waiting.empty() || !running.empty())
+	{
+	    // Start all ready actions in order of the commit order.
+
+	    for (list<vertex_descriptor>::iterator it = waiting.begin(); !abort_exception && it != waiting.end(); )
+	    {
+		vertex_descriptor vertex = *it;
+		const Action::Base* action = graph[vertex].get();
+
+		if (pending_parents[vertex] > 0)
+		{
+		    ++it;
+		    continue;
+		}
+
+		if (failed.count(vertex) > 0)
+		{
+		    it = waiting.erase(it);
+		    finish(vertex, false);
+		    it = waiting.begin();
+		    continue;
+		}
+
+		if (running.size() >= commit_options.max_parallel_actions)
+		    break;
+
+		if (running_sids.count(action->sid) > 0)
+		{
+		    ++it;
+		    continue;
+		}
+
+		it = waiting.erase(it);
+
+		Text text = action->text(commit_data);
+
+		y2mil("Commit Action \"" << text.native << "\" [" << action->details() << "]");
+
+		try
+		{
+		    message_callback(commit_callbacks, text);
+		}
+		catch (...)
+		{
+		    abort_exception = current_exception();
+		    break;
+		}
+
+		if (action->nop)
+		{
+		    finish(vertex, true);
+		    it = waiting.begin();
+		    continue;
+		}
+
+		if (is_config_files_barrier(vertex))
+		    commit_data.write_config_files();
+
+		running_sids.insert(action->sid);
+
+		running[vertex] = thread([&, vertex, action]() {
+
+		    exception_ptr exception;
+
+		    {
+			LibraryLock::Guard guard;
+
+			try
+			{
+			    action->commit(commit_data, commit_options);
+			}
+			catch (...)
+			{
+			    exception = current_exception();
+			}
+		    }
+
+		    lock_guard<mutex> lock(results_mutex);
+		    results.push_back({ vertex, exception });
+		    results_cv.notify_one();
+		});
+	    }
+
+	    if (running.empty())
+	    {
+		if (abort_exception || waiting.empty())
+		    break;
+
+		ST_THROW(LogicException("no action ready to commit"));
+	    }
+
+	    // Wait for at least one action to finish.
+
+	    vector<Result> finished;
+
+	    {
+		LibraryLock::Unlock unlock;
+
+		unique_lock<mutex> lock(results_mutex);
+		results_cv.wait(lock, [&results]() { return !results.empty(); });
+		finished.swap(results);
+	    }
+
+	    for (const Result& result : finished)
+	    {
+		running[result.vertex].join();
+		running.erase(result.vertex);
+		running_sids.erase(graph[result.vertex]->sid);
+
+		if (!result.exception)
+		{
+		    finish(result.vertex, true);
+		    continue;
+		}
+
+		try
+		{
+		    rethrow_exception(result.exception);
+		}
+		catch (const Exception& exception)
+		{
+		    if (!abort_exception)
+		    {
+			try
+			{
+			    Text text = graph[result.vertex]->text(commit_data);
+			    error_callback(commit_callbacks, text, exception);
+			}
+			catch (...)
+			{
+			    abort_exception = current_exception();
+			}
+		    }
+		}
+		catch (...)
+		{
+		    if (!abort_exception)
+			abort_exception = current_exception();
+		}
+
+		finish(result.vertex, false);
+	    }
+	}
+
+	if (abort_exception)
+	    rethrow_exception(abort_exception);
     }
 
 
@@ -28,6 +28,8 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <typeindex>
 #include <boost/noncopyable.hpp>
 #include <boost/graph/adjacency_list.hpp>
 
@@ -72,7 +74,7 @@ namespace storage
     {
     public:
 
-	CommitData(const Actiongraph::Impl& actiongraph, Tense tense);
+	CommitData(const Actiongraph::Impl& actiongraph, Tense tense, bool defer_config_files = false);
 	~CommitData();
 
 	const Actiongraph::Impl& actiongraph;
@@ -82,12 +84,31 @@ namespace storage
 	EtcCrypttab& get_etc_crypttab();
 	EtcMdadm& get_etc_mdadm();
 
+	/**
+	 * Write /etc/fstab or /etc/crypttab after it was modified. If
+	 * writes are deferred the file is only marked as modified.
+	 */
+	void write_etc_fstab();
+	void write_etc_crypttab();
+
+	/**
+	 * Write all modified config files if writes are deferred. Must be
+	 * called before actions that need the config files on disk and at
+	 * the end of the commit.
+	 */
+	void write_config_files();
+
     private:
 
+	const bool defer_config_files;
+
 	std::unique_ptr<EtcFstab> etc_fstab;
 	std::unique_ptr<EtcCrypttab> etc_crypttab;
 	std::unique_ptr<EtcMdadm> etc_mdadm;
 
+	bool etc_fstab_modified = false;
+	bool etc_crypttab_modified = false;
+
     };
 
 
@@ -157,6 +178,28 @@ namespace storage
 	const vector<vertex_descriptor>& actions_with_sid(sid_t sid) const;
 	vector<vertex_descriptor> actions_with_sid(sid_t sid, ActionsFilter actions_filter) const;
 
+	/**
+	 * Returns all actions of type ActionType, e.g. Action::Create, on
+	 * devices of type DeviceType, e.g. Partition. The actions are
+	 * grouped by their exact types, within a group they are in the
+	 * order they were added.
+	 */
+	template <typename ActionType, typename DeviceType = Device>
+	vector<vertex_descriptor>
+	actions_of_type() const
+	{
+	    vector<vertex_descriptor> ret;
+
+	    for (const TypedActions& typed_actions : get_typed_actions())
+	    {
+		if (dynamic_cast<const ActionType*>(typed_actions.action) &&
+		    dynamic_cast<const DeviceType*>(typed_actions.device))
+		    ret.insert(ret.end(), typed_actions.vertices.begin(), typed_actions.vertices.end());
+	    }
+
+	    return ret;
+	}
+
 	boost::iterator_range<vertex_iterator> vertices() const;
 
 	boost::iterator_range<adjacency_iterator> children(vertex_descriptor vertex) const;
@@ -178,6 +221,7 @@ namespace storage
 
 	// special actions, TODO make private and provide interface
 	vertex_iterator mount_root_filesystem;
+	vertex_iterator unmount_root_filesystem;
 	map<sid_t, vertex_descriptor> last_action_on_partition_table;
 
     private:
@@ -192,6 +236,50 @@ namespace storage
 	void remove_only_syncs();
 	void calculate_order();
 
+	void commit_serial(CommitData& commit_data, const CommitOptions& commit_options,
+			   const CommitCallbacks* commit_callbacks) const;
+	void commit_parallel(CommitData& commit_data, const CommitOptions& commit_options,
+			     const CommitCallbacks* commit_callbacks) const;
+
+	/**
+	 * Check whether actions can be committed by worker threads.
+	 */
+	bool is_parallel_commit_possible() const;
+
+	/**
+	 * Check whether the modified config files must be written before the
+	 * action is committed.
+	 */
+	bool is_config_files_barrier(vertex_descriptor vertex) const;
+
+	// Index of the actions by the exact types of the action and the
+	// device. Updated when actions are added and rebuilt on the next
+	// query after actions were removed. The action and device of the
+	// first entry are used to check the types in actions_of_type().
+
+	struct TypedActions
+	{
+	    const Action::Base* action;
+	    const Device* device;
+	    vector<vertex_descriptor> vertices;
+	};
+
+	struct TypedActionsKeyHash
+	{
+	    size_t operator()(const std::pair<std::type_index, std::type_index>& key) const
+	    {
+		return key.first.hash_code() ^ (key.second.hash_code() << 1);
+	    }
+	};
+
+	mutable vector<TypedActions> typed_actions;
+	mutable std::unordered_map<std::pair<std::type_index, std::type_index>, size_t,
+				   TypedActionsKeyHash> typed_actions_index;
+	mutable bool typed_actions_valid = true;
+
+	void add_to_typed_actions(vertex_descriptor vertex) const;
+	const vector<TypedActions>& get_typed_actions() const;
+
 	const Storage& storage;
 
 	Devicegraph* lhs;
@@ -203,7 +291,10 @@ namespace storage
 
 	graph_t graph;
 
-	map<sid_t, vector<vertex_descriptor>> cache_for_actions_with_sid;
+	std::unordered_map<sid_t, vector<vertex_descriptor>> cache_for_actions_with_sid;
+
+	// actions with only_sync set, set in set_special_actions()
+	vector<vertex_descriptor> only_sync_actions;
 
 	vector<shared_ptr<CompoundAction>> compound_actions;
 
@@ -32,11 +32,40 @@ namespace storage
     {
     public:
 
-	CommitOptions(bool force_rw)
-	    : force_rw(force_rw) {}
+	CommitOptions(bool force_rw, unsigned int max_parallel_actions = 1,
+		      bool defer_config_files = false)
+	    : force_rw(force_rw), max_parallel_actions(max_parallel_actions),
+	      defer_config_files(defer_config_files) {}
 
 	const bool force_rw;
 
+	/**
+	 * Maximal number of actions committed at the same time. Actions are
+	 * only run in parallel if all their predecessors in the actiongraph
+	 * have finished and they do not work on the same device. Messages
+	 * and errors are still reported one after another via the commit
+	 * callbacks. If more than one action is allowed, the actions
+	 * depending on a failed action are skipped.
+	 *
+	 * The actions are run by worker threads which log and may run
+	 * commands via the remote callbacks. Since loggers and remote
+	 * callbacks implemented in the bindings must not be called from
+	 * other threads, the actions are committed one after another if a
+	 * logger other than the ones of the library or remote callbacks are
+	 * set.
+	 */
+	const unsigned int max_parallel_actions;
+
+	/**
+	 * Collect the changes to /etc/fstab, /etc/crypttab and
+	 * /etc/mdadm.conf and write each file only once instead of after
+	 * every change. The files are written before mounting or
+	 * unmounting the root filesystem, before actions that need the
+	 * files and at the end of the commit. The files are replaced
+	 * atomically if possible, losing ACLs and extended attributes.
+	 */
+	const bool defer_config_files;
+
     };
 
 }
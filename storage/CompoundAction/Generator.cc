@@ -20,7 +20,7 @@
  */
 
 
-#include <algorithm>
+#include <unordered_map>
 
 #include "storage/CompoundAction/Generator.h"
 #include "storage/CompoundActionImpl.h"
@@ -38,43 +38,28 @@ namespace storage
     {
 	vector<CompoundAction*> compound_actions;
 
+	// The compound actions are in the order of the first commit action
+	// for the target device. The map is only used to find them quickly.
+
+	std::unordered_map<const Device*, CompoundAction*> compound_actions_by_target;
+
 	for (auto& commit_action : actiongraph->get_commit_actions())
 	{
 	    auto target = CompoundAction::Impl::get_target_device(actiongraph, commit_action);
 
-	    auto compound_action = find_by_target_device(compound_actions, target);
+	    auto& compound_action = compound_actions_by_target[target];
 
-	    if (compound_action)
-		compound_action->get_impl().add_commit_action(commit_action);
-	    else
+	    if (!compound_action)
 	    {
 		compound_action = new CompoundAction(actiongraph);
 		compound_action->get_impl().set_target_device(target);
-		compound_action->get_impl().add_commit_action(commit_action);
 		compound_actions.push_back(compound_action);
 	    }
+
+	    compound_action->get_impl().add_commit_action(commit_action);
 	}
 
 	return compound_actions;
     }
 
-
-    CompoundAction*
-    CompoundAction::Generator::find_by_target_device(const vector<CompoundAction*>& compound_actions, const Device* device)
-    {
-	auto begin = compound_actions.begin();
-	auto end = compound_actions.end();
-
-	auto it = find_if(begin, end,
-		[device](CompoundAction* a) -> bool
-		{
-		    return a->get_target_device() == device;
-		});
-
-	if (it != end)
-	    return *it;
-	else
-	    return nullptr;
-    }
-
 }
@@ -34,7 +34,6 @@ namespace storage
     using std::vector;
 
     class Actiongraph;
-    class Device;
 
     class CompoundAction::Generator
     {
@@ -45,10 +44,6 @@ namespace storage
 
 	vector<CompoundAction*> generate() const;
 
-    private:
-
-	static CompoundAction* find_by_target_device(const vector<CompoundAction*>& compound_actions, const Device* device);
-
     private:
 
 	const Actiongraph* actiongraph;
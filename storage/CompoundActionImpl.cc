@@ -80,7 +80,7 @@ namespace storage
     }
 
 
-    vector<const Action::Base*> CompoundAction::Impl::get_commit_actions() const
+    const vector<const Action::Base*>& CompoundAction::Impl::get_commit_actions() const
     {
 	return commit_actions;
     }
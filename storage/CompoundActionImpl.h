@@ -56,7 +56,7 @@ namespace storage
 	const Device* get_target_device() const;
 
 	void set_commit_actions(vector<const Action::Base*> actions);
-	vector<const Action::Base*> get_commit_actions() const; 
+	const vector<const Action::Base*>& get_commit_actions() const;
 
 	void add_commit_action(const Action::Base* action);
     
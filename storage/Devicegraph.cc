@@ -156,7 +156,14 @@ namespace storage
     void
     Devicegraph::save(const string& filename) const
     {
-	get_impl().save(filename);
+	get_impl().save(filename, DevicegraphFormat::XML);
+    }
+
+
+    void
+    Devicegraph::save(const string& filename, DevicegraphFormat format) const
+    {
+	get_impl().save(filename, format);
     }
 
 
@@ -265,7 +272,7 @@ namespace storage
 	    g_out.get_impl().graph[v_out].reset(g_in.get_impl().graph[v_in]->clone());
 
 	    Device* d_out = g_out.get_impl().graph[v_out].get();
-	    d_out->get_impl().set_devicegraph_and_vertex(&g_out, v_out);
+	    Device::Impl::set_back_references(d_out, &g_out, v_out);
 	}
 
 	void operator()(const Devicegraph::Impl::edge_descriptor& e_in,
@@ -398,6 +405,8 @@ namespace storage
 	boost::copy_graph(get_impl().graph, dest.get_impl().graph,
 			  vertex_index_map(vertex_index_map_generator.get()).
 			  vertex_copy(copier).edge_copy(copier));
+
+	dest.get_impl().rebuild_indices();
     }
 
 
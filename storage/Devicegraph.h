@@ -45,6 +45,13 @@ namespace storage
     class CheckCallbacks;
 
 
+    //! Format of devicegraph files
+    enum class DevicegraphFormat {
+	XML,			// XML, human readable
+	BINARY			// compact binary format, fast to load
+    };
+
+
     class DeviceNotFound : public Exception
     {
     public:
@@ -165,15 +172,28 @@ namespace storage
 	const Storage* get_storage() const;
 
 	/**
+	 * Load the devicegraph from a file. The format of the file is
+	 * detected automatically.
+	 *
 	 * @throw Exception
 	 */
 	void load(const std::string& filename);
 
 	/**
+	 * Save the devicegraph to a file in XML format.
+	 *
 	 * @throw Exception
 	 */
 	void save(const std::string& filename) const;
 
+	/**
+	 * Save the devicegraph to a file in the given format. Converting
+	 * between the formats is lossless.
+	 *
+	 * @throw Exception
+	 */
+	void save(const std::string& filename, DevicegraphFormat format) const;
+
 	bool empty() const;
 
 	size_t num_devices() const;
@@ -281,7 +301,7 @@ namespace storage
 
     private:
 
-	const std::unique_ptr<Impl> impl;
+	std::unique_ptr<Impl> impl;
 
     };
 
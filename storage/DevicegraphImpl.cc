@@ -21,14 +21,18 @@
  */
 
 
+#include <string.h>
+#include <atomic>
 #include <boost/graph/copy.hpp>
 #include <boost/graph/reverse_graph.hpp>
 #include <boost/graph/graphviz.hpp>
 #include <boost/graph/graph_utility.hpp>
+#include <libxml/xmlreader.h>
 
 #include "storage/DevicegraphImpl.h"
 #include "storage/Utils/GraphUtils.h"
 #include "storage/Utils/XmlFile.h"
+#include "storage/Utils/BinaryFile.h"
 #include "storage/Utils/StorageTmpl.h"
 #include "storage/Utils/HumanString.h"
 #include "storage/Utils/StorageDefines.h"
@@ -170,85 +174,265 @@ namespace storage
     }
 
 
+    void
+    Devicegraph::Impl::touch()
+    {
+	static std::atomic<unsigned long> last_generation(0);
+
+	generation = ++last_generation;
+    }
+
+
+    void
+    Devicegraph::Impl::mark_unchecked(vertex_descriptor vertex)
+    {
+	touch();
+
+	unchecked_devices.insert(graph[vertex]->get_sid());
+    }
+
+
+    void
+    Devicegraph::Impl::mark_unchecked(edge_descriptor edge)
+    {
+	touch();
+
+	unchecked_holders.insert(make_pair(graph[source(edge)]->get_sid(), graph[target(edge)]->get_sid()));
+    }
+
+
+    void
+    Devicegraph::Impl::mark_all_unchecked()
+    {
+	touch();
+
+	check_all = true;
+
+	unchecked_devices.clear();
+	unchecked_holders.clear();
+    }
+
+
     void
     Devicegraph::Impl::check(const CheckCallbacks* check_callbacks) const
     {
+	if (checked_generation != generation)
 	{
-	    // check uniqueness of device and holder object and sid
+	    // A device or holder added twice or an index entry overwritten
+	    // only shows up in the sizes of the sid indices. In that case
+	    // the complete graph is checked to find the culprit.
+
+	    if (check_all || vertex_index.size() != num_devices() || edge_index.size() != num_holders())
+		check_graph();
+	    else
+		check_unchecked();
 
-	    // check device and holder back reference
+	    checked_generation = generation;
 
-	    set<const Device*> devices;
-	    set<const Holder*> holders;
-	    set<sid_t> sids;
+	    check_all = false;
 
+	    unchecked_devices.clear();
+	    unchecked_holders.clear();
+	}
+
+	{
 	    for (vertex_descriptor vertex : vertices())
 	    {
-		// check uniqueness of device object
-
 		const Device* device = graph[vertex].get();
-		if (!devices.insert(device).second)
-		    ST_THROW(LogicException("device object not unique within graph"));
+		device->get_impl().check(check_callbacks);
+	    }
+	}
 
-		// check uniqueness of device sid
+	// TODO check that out-edges are consistent, e.g. of same type, only one per Subdevice
+	// TODO check that in-edges are consistent, e.g. of same type, exactly one for Partition
+	// in general subcheck for each device
+    }
 
-		sid_t sid = device->get_sid();
-		if (!sids.insert(sid).second)
-		    ST_THROW(LogicException(sformat("sid %d not unique within graph", sid)));
 
-		// check device back reference
+    void
+    Devicegraph::Impl::check_graph() const
+    {
+	// check uniqueness of device and holder object and sid
 
-		if (&device->get_impl().get_devicegraph()->get_impl() != this)
-		    ST_THROW(LogicException("wrong graph in back references"));
+	// check device and holder back reference
 
-		if (device->get_impl().get_vertex() != vertex)
-		    ST_THROW(LogicException("wrong vertex in back references"));
-	    }
+	set<const Device*> devices;
+	set<const Holder*> holders;
+	set<sid_t> sids;
 
-	    for (edge_descriptor edge : edges())
-	    {
-		// check uniqueness of holder object
+	for (vertex_descriptor vertex : vertices())
+	{
+	    // check uniqueness of device object
 
-		const Holder* holder = graph[edge].get();
-		if (!holders.insert(holder).second)
-		    ST_THROW(LogicException("holder object not unique within graph"));
+	    const Device* device = graph[vertex].get();
+	    if (!devices.insert(device).second)
+		ST_THROW(LogicException("device object not unique within graph"));
 
-		// check holder back reference
+	    // check uniqueness of device sid
 
-		if (&holder->get_impl().get_devicegraph()->get_impl() != this)
-		    ST_THROW(LogicException("wrong graph in back references"));
+	    sid_t sid = device->get_sid();
+	    if (!sids.insert(sid).second)
+		ST_THROW(LogicException(sformat("sid %d not unique within graph", sid)));
 
-		if (holder->get_impl().get_edge() != edge)
-		    ST_THROW(LogicException("wrong edge in back references"));
-	    }
+	    check_back_references(vertex);
 	}
 
+	for (edge_descriptor edge : edges())
 	{
-	    // look for cycles
+	    // check uniqueness of holder object
+
+	    const Holder* holder = graph[edge].get();
+	    if (!holders.insert(holder).second)
+		ST_THROW(LogicException("holder object not unique within graph"));
+
+	    check_back_references(edge);
+	}
+
+	// check sid indices
 
-	    VertexIndexMapGenerator<graph_t> vertex_index_map_generator(graph);
+	if (vertex_index.size() != num_devices() || edge_index.size() != num_holders())
+	    ST_THROW(LogicException("sid indices out of sync with graph"));
+
+	// check name and UUID indices
+
+	for (vertex_descriptor vertex : vertices())
+	    check_string_indices(vertex);
+
+	// look for cycles
+
+	VertexIndexMapGenerator<graph_t> vertex_index_map_generator(graph);
 
-	    bool has_cycle = false;
+	bool has_cycle = false;
 
-	    CycleDetector cycle_detector(has_cycle);
-	    boost::depth_first_search(graph, visitor(cycle_detector).
-				      vertex_index_map(vertex_index_map_generator.get()));
+	CycleDetector cycle_detector(has_cycle);
+	boost::depth_first_search(graph, visitor(cycle_detector).
+				  vertex_index_map(vertex_index_map_generator.get()));
 
-	    if (has_cycle)
-		ST_THROW(Exception("devicegraph has a cycle"));
+	if (has_cycle)
+	    ST_THROW(Exception("devicegraph has a cycle"));
+    }
+
+
+    void
+    Devicegraph::Impl::check_unchecked() const
+    {
+	// Devices and holders removed since they were marked are
+	// skipped. The sids of the remaining ones are unique since the
+	// sizes of the sid indices match the graph.
+
+	for (sid_t sid : unchecked_devices)
+	{
+	    vertex_index_t::const_iterator it = vertex_index.find(sid);
+	    if (it == vertex_index.end())
+		continue;
+
+	    vertex_descriptor vertex = it->second;
+
+	    if (graph[vertex]->get_sid() != sid)
+		ST_THROW(LogicException("sid indices out of sync with graph"));
+
+	    check_back_references(vertex);
+	    check_string_indices(vertex);
 	}
 
+	for (const pair<sid_t, sid_t>& sids : unchecked_holders)
 	{
-	    for (vertex_descriptor vertex : vertices())
+	    edge_index_t::const_iterator it = edge_index.find(sids);
+	    if (it == edge_index.end())
+		continue;
+
+	    edge_descriptor edge = it->second;
+
+	    if (graph[source(edge)]->get_sid() != sids.first || graph[target(edge)]->get_sid() != sids.second)
+		ST_THROW(LogicException("sid indices out of sync with graph"));
+
+	    check_back_references(edge);
+
+	    // A new holder creates a cycle if its source can be reached from
+	    // its target. Only the descendants of the target are visited.
+
+	    vertex_descriptor source_vertex = source(edge);
+
+	    set<vertex_descriptor> visited;
+	    vector<vertex_descriptor> stack = { target(edge) };
+
+	    while (!stack.empty())
 	    {
-		const Device* device = graph[vertex].get();
-		device->get_impl().check(check_callbacks);
+		vertex_descriptor vertex = stack.back();
+		stack.pop_back();
+
+		if (vertex == source_vertex)
+		    ST_THROW(Exception("devicegraph has a cycle"));
+
+		if (!visited.insert(vertex).second)
+		    continue;
+
+		for (vertex_descriptor child : boost::make_iterator_range(boost::adjacent_vertices(vertex, graph)))
+		    stack.push_back(child);
 	    }
 	}
+    }
 
-	// TODO check that out-edges are consistent, e.g. of same type, only one per Subdevice
-	// TODO check that in-edges are consistent, e.g. of same type, exactly one for Partition
-	// in general subcheck for each device
+
+    void
+    Devicegraph::Impl::check_back_references(vertex_descriptor vertex) const
+    {
+	const Device* device = graph[vertex].get();
+
+	// A clone sharing its implementation only knows its devicegraph.
+
+	if (const Devicegraph* shared_devicegraph = Device::Impl::get_shared_devicegraph(device))
+	{
+	    if (&shared_devicegraph->get_impl() != this)
+		ST_THROW(LogicException("wrong graph in back references"));
+
+	    return;
+	}
+
+	if (&device->get_impl().get_devicegraph()->get_impl() != this)
+	    ST_THROW(LogicException("wrong graph in back references"));
+
+	if (device->get_impl().get_vertex() != vertex)
+	    ST_THROW(LogicException("wrong vertex in back references"));
+    }
+
+
+    void
+    Devicegraph::Impl::check_back_references(edge_descriptor edge) const
+    {
+	const Holder* holder = graph[edge].get();
+
+	if (&holder->get_impl().get_devicegraph()->get_impl() != this)
+	    ST_THROW(LogicException("wrong graph in back references"));
+
+	if (holder->get_impl().get_edge() != edge)
+	    ST_THROW(LogicException("wrong edge in back references"));
+    }
+
+
+    void
+    Devicegraph::Impl::check_string_indices(vertex_descriptor vertex) const
+    {
+	auto is_indexed = [vertex](const string_index_t& index, const string& key) {
+	    auto range = index.equal_range(key);
+	    return key.empty() || find_if(range.first, range.second, [vertex](const string_index_t::value_type& value) {
+		return value.second == vertex;
+	    }) != range.second;
+	};
+
+	const Device::Impl& device_impl = Device::Impl::get_shared_impl(graph[vertex].get());
+
+	if (!is_indexed(name_index, device_impl.get_index_name()))
+	    ST_THROW(LogicException("name index out of sync with graph"));
+
+	if (!is_indexed(uuid_index, device_impl.get_index_uuid()))
+	    ST_THROW(LogicException("UUID index out of sync with graph"));
+
+	for (const string& alias : device_impl.get_index_aliases())
+	{
+	    if (!is_indexed(alias_index, alias))
+		ST_THROW(LogicException("alias index out of sync with graph"));
+	}
     }
 
 
@@ -326,7 +510,30 @@ namespace storage
     Devicegraph::Impl::vertex_descriptor
     Devicegraph::Impl::add_vertex(Device* device)
     {
-	return boost::add_vertex(shared_ptr<Device>(device), graph);
+	vertex_descriptor vertex = boost::add_vertex(shared_ptr<Device>(device), graph);
+
+	mark_unchecked(vertex);
+
+	vertex_index[device->get_sid()] = vertex;
+
+	const Device::Impl& device_impl = Device::Impl::get_shared_impl(device);
+
+	add_to_string_index(name_index, device_impl.get_index_name(), vertex);
+	add_to_string_index(uuid_index, device_impl.get_index_uuid(), vertex);
+
+	for (const string& alias : device_impl.get_index_aliases())
+	    add_to_string_index(alias_index, alias, vertex);
+
+	unsigned long position = next_vertex_position++;
+	vertex_positions[vertex] = position;
+
+	for (type_index_t::value_type& value : type_index)
+	{
+	    if (value.second.is_of_type(device))
+		value.second.vertices.emplace_hint(value.second.vertices.end(), position, vertex);
+	}
+
+	return vertex;
     }
 
 
@@ -341,6 +548,10 @@ namespace storage
 	    ST_THROW(HolderAlreadyExists(graph[source_vertex]->get_sid(),
 					 graph[target_vertex]->get_sid()));
 
+	mark_unchecked(tmp.first);
+
+	add_to_edge_index(tmp.first);
+
 	// TODO should also set devicegraph and edge in holder but the
 	// devicegraph is not available here
 
@@ -348,6 +559,45 @@ namespace storage
     }
 
 
+    void
+    Devicegraph::Impl::add_to_edge_index(edge_descriptor edge)
+    {
+	edge_index[make_pair(graph[source(edge)]->get_sid(), graph[target(edge)]->get_sid())] = edge;
+    }
+
+
+    void
+    Devicegraph::Impl::remove_from_edge_index(edge_descriptor edge)
+    {
+	edge_index.erase(make_pair(graph[source(edge)]->get_sid(), graph[target(edge)]->get_sid()));
+    }
+
+
+    void
+    Devicegraph::Impl::add_to_string_index(string_index_t& index, const string& key,
+					   vertex_descriptor vertex)
+    {
+	if (!key.empty())
+	    index.emplace(key, vertex);
+    }
+
+
+    void
+    Devicegraph::Impl::remove_from_string_index(string_index_t& index, const string& key,
+						vertex_descriptor vertex)
+    {
+	auto range = index.equal_range(key);
+	for (string_index_t::const_iterator it = range.first; it != range.second; ++it)
+	{
+	    if (it->second == vertex)
+	    {
+		index.erase(it);
+		return;
+	    }
+	}
+    }
+
+
     set<sid_t>
     Devicegraph::Impl::get_device_sids() const
     {
@@ -371,54 +621,53 @@ namespace storage
     bool
     Devicegraph::Impl::device_exists(sid_t sid) const
     {
-	for (vertex_descriptor vertex : vertices())
-	{
-	    if (graph[vertex]->get_sid() == sid)
-		return true;
-	}
-
-	return false;
+	return vertex_index.find(sid) != vertex_index.end();
     }
 
 
     bool
     Devicegraph::Impl::holder_exists(sid_t source_sid, sid_t target_sid) const
     {
-	for (edge_descriptor edge : edges())
-	{
-	    if (graph[source(edge)]->get_sid() == source_sid &&
-		graph[target(edge)]->get_sid() == target_sid)
-		return true;
-	}
-
-	return false;
+	return edge_index.find(make_pair(source_sid, target_sid)) != edge_index.end();
     }
 
 
     Devicegraph::Impl::vertex_descriptor
     Devicegraph::Impl::find_vertex(sid_t sid) const
     {
+	vertex_index_t::const_iterator it = vertex_index.find(sid);
+	if (it == vertex_index.end())
+	    ST_THROW(DeviceNotFoundBySid(sid));
+
+	return it->second;
+    }
+
+
+    Devicegraph::Impl::vertex_descriptor
+    Devicegraph::Impl::find_vertex(const Device* device) const
+    {
+	vertex_index_t::const_iterator it = vertex_index.find(device->get_sid());
+	if (it != vertex_index.end() && graph[it->second].get() == device)
+	    return it->second;
+
 	for (vertex_descriptor vertex : vertices())
 	{
-	    if (graph[vertex]->get_sid() == sid)
+	    if (graph[vertex].get() == device)
 		return vertex;
 	}
 
-	ST_THROW(DeviceNotFoundBySid(sid));
-     }
+	ST_THROW(DeviceNotFoundBySid(device->get_sid()));
+    }
 
 
     Devicegraph::Impl::edge_descriptor
     Devicegraph::Impl::find_edge(sid_t source_sid, sid_t target_sid) const
     {
-	for (edge_descriptor edge : edges())
-	{
-	    if (graph[source(edge)]->get_sid() == source_sid &&
-		graph[target(edge)]->get_sid() == target_sid)
-		return edge;
-	}
+	edge_index_t::const_iterator it = edge_index.find(make_pair(source_sid, target_sid));
+	if (it == edge_index.end())
+	    ST_THROW(HolderNotFoundBySids(source_sid, target_sid));
 
-	ST_THROW(HolderNotFoundBySids(source_sid, target_sid));
+	return it->second;
     }
 
 
@@ -444,13 +693,54 @@ namespace storage
     void
     Devicegraph::Impl::clear()
     {
+	mark_all_unchecked();
+
 	graph.clear();
+
+	vertex_index.clear();
+	edge_index.clear();
+
+	name_index.clear();
+	uuid_index.clear();
+	alias_index.clear();
+
+	vertex_positions.clear();
+	type_index.clear();
     }
 
 
     void
     Devicegraph::Impl::remove_vertex(vertex_descriptor vertex)
     {
+	touch();
+
+	for (edge_descriptor edge : boost::make_iterator_range(boost::in_edges(vertex, graph)))
+	    remove_from_edge_index(edge);
+
+	for (edge_descriptor edge : boost::make_iterator_range(boost::out_edges(vertex, graph)))
+	    remove_from_edge_index(edge);
+
+	const Device* device = graph[vertex].get();
+
+	vertex_index.erase(device->get_sid());
+
+	const Device::Impl& device_impl = Device::Impl::get_shared_impl(device);
+
+	remove_from_string_index(name_index, device_impl.get_index_name(), vertex);
+	remove_from_string_index(uuid_index, device_impl.get_index_uuid(), vertex);
+
+	for (const string& alias : device_impl.get_index_aliases())
+	    remove_from_string_index(alias_index, alias, vertex);
+
+	vertex_positions_t::iterator it = vertex_positions.find(vertex);
+	if (it != vertex_positions.end())
+	{
+	    for (type_index_t::value_type& value : type_index)
+		value.second.vertices.erase(it->second);
+
+	    vertex_positions.erase(it);
+	}
+
 	boost::clear_vertex(vertex, graph);
 	boost::remove_vertex(vertex, graph);
     }
@@ -459,14 +749,138 @@ namespace storage
     void
     Devicegraph::Impl::remove_edge(edge_descriptor edge)
     {
+	touch();
+
+	remove_from_edge_index(edge);
+
 	boost::remove_edge(edge, graph);
     }
 
 
     void
-    Devicegraph::Impl::swap(Devicegraph::Impl& x)
+    Devicegraph::Impl::swap(Devicegraph& lhs, Devicegraph& rhs)
+    {
+	// boost::adjacency_list::swap copies the graphs, so swap the
+	// implementations instead.
+
+	lhs.impl.swap(rhs.impl);
+    }
+
+
+    void
+    Devicegraph::Impl::rebuild_indices()
     {
-	graph.swap(x.graph);
+	mark_all_unchecked();
+
+	vertex_index.clear();
+	edge_index.clear();
+
+	name_index.clear();
+	uuid_index.clear();
+	alias_index.clear();
+
+	vertex_positions.clear();
+	type_index.clear();
+
+	for (vertex_descriptor vertex : vertices())
+	{
+	    const Device::Impl& device_impl = Device::Impl::get_shared_impl(graph[vertex].get());
+
+	    vertex_index[device_impl.get_sid()] = vertex;
+
+	    add_to_string_index(name_index, device_impl.get_index_name(), vertex);
+	    add_to_string_index(uuid_index, device_impl.get_index_uuid(), vertex);
+
+	    for (const string& alias : device_impl.get_index_aliases())
+		add_to_string_index(alias_index, alias, vertex);
+
+	    vertex_positions[vertex] = next_vertex_position++;
+	}
+
+	for (edge_descriptor edge : edges())
+	    add_to_edge_index(edge);
+    }
+
+
+    void
+    Devicegraph::Impl::set_back_references(Devicegraph* devicegraph)
+    {
+	mark_all_unchecked();
+
+	for (vertex_descriptor vertex : vertices())
+	    Device::Impl::set_back_references(graph[vertex].get(), devicegraph, vertex);
+
+	for (edge_descriptor edge : edges())
+	    graph[edge]->get_impl().set_devicegraph_and_edge(devicegraph, edge);
+    }
+
+
+    void
+    Devicegraph::Impl::update_sid_indices(vertex_descriptor vertex, sid_t old_sid)
+    {
+	mark_unchecked(vertex);
+
+	// Only remove entries still pointing to this vertex or its edges since
+	// several sids may be exchanged one after another.
+
+	vertex_index_t::const_iterator it1 = vertex_index.find(old_sid);
+	if (it1 != vertex_index.end() && it1->second == vertex)
+	    vertex_index.erase(it1);
+
+	vertex_index[graph[vertex]->get_sid()] = vertex;
+
+	for (edge_descriptor edge : in_edges(vertex))
+	{
+	    edge_index_t::const_iterator it2 = edge_index.find(make_pair(graph[source(edge)]->get_sid(), old_sid));
+	    if (it2 != edge_index.end() && it2->second == edge)
+		edge_index.erase(it2);
+
+	    add_to_edge_index(edge);
+	    mark_unchecked(edge);
+	}
+
+	for (edge_descriptor edge : out_edges(vertex))
+	{
+	    edge_index_t::const_iterator it2 = edge_index.find(make_pair(old_sid, graph[target(edge)]->get_sid()));
+	    if (it2 != edge_index.end() && it2->second == edge)
+		edge_index.erase(it2);
+
+	    add_to_edge_index(edge);
+	    mark_unchecked(edge);
+	}
+    }
+
+
+    void
+    Devicegraph::Impl::update_name_index(vertex_descriptor vertex, const string& old_name)
+    {
+	mark_unchecked(vertex);
+
+	remove_from_string_index(name_index, old_name, vertex);
+	add_to_string_index(name_index, graph[vertex]->get_impl().get_index_name(), vertex);
+    }
+
+
+    void
+    Devicegraph::Impl::update_uuid_index(vertex_descriptor vertex, const string& old_uuid)
+    {
+	mark_unchecked(vertex);
+
+	remove_from_string_index(uuid_index, old_uuid, vertex);
+	add_to_string_index(uuid_index, graph[vertex]->get_impl().get_index_uuid(), vertex);
+    }
+
+
+    void
+    Devicegraph::Impl::update_alias_index(vertex_descriptor vertex, const vector<string>& old_aliases)
+    {
+	mark_unchecked(vertex);
+
+	for (const string& old_alias : old_aliases)
+	    remove_from_string_index(alias_index, old_alias, vertex);
+
+	for (const string& alias : graph[vertex]->get_impl().get_index_aliases())
+	    add_to_string_index(alias_index, alias, vertex);
     }
 
 
@@ -548,12 +962,9 @@ namespace storage
     {
 	vector<vertex_descriptor> ret;
 
-	VertexIndexMapGenerator<graph_t> vertex_index_map_generator(graph);
-
 	VertexRecorder<vertex_descriptor> vertex_recorder(false, ret);
 
-	boost::breadth_first_search(graph, vertex, visitor(vertex_recorder).
-				    vertex_index_map(vertex_index_map_generator.get()));
+	local_breadth_first_search(graph, vertex, vertex_recorder);
 
 	if (!itself)
 	    ret.erase(remove(ret.begin(), ret.end(), vertex), ret.end());
@@ -571,12 +982,9 @@ namespace storage
 
 	reverse_graph_t reverse_graph(graph);
 
-	VertexIndexMapGenerator<reverse_graph_t> vertex_index_map_generator(reverse_graph);
-
 	VertexRecorder<vertex_descriptor> vertex_recorder(false, ret);
 
-	boost::breadth_first_search(reverse_graph, vertex, visitor(vertex_recorder).
-				    vertex_index_map(vertex_index_map_generator.get()));
+	local_breadth_first_search(reverse_graph, vertex, vertex_recorder);
 
 	if (!itself)
 	    ret.erase(remove(ret.begin(), ret.end(), vertex), ret.end());
@@ -590,12 +998,9 @@ namespace storage
     {
 	vector<vertex_descriptor> ret;
 
-	VertexIndexMapGenerator<graph_t> vertex_index_map_generator(graph);
-
 	VertexRecorder<vertex_descriptor> vertex_recorder(true, ret);
 
-	boost::breadth_first_search(graph, vertex, visitor(vertex_recorder).
-				    vertex_index_map(vertex_index_map_generator.get()));
+	local_breadth_first_search(graph, vertex, vertex_recorder);
 
 	if (!itself)
 	    ret.erase(remove(ret.begin(), ret.end(), vertex), ret.end());
@@ -613,12 +1018,9 @@ namespace storage
 
 	reverse_graph_t reverse_graph(graph);
 
-	VertexIndexMapGenerator<reverse_graph_t> vertex_index_map_generator(graph);
-
 	VertexRecorder<vertex_descriptor> vertex_recorder(true, ret);
 
-	boost::breadth_first_search(reverse_graph, vertex, visitor(vertex_recorder).
-				    vertex_index_map(vertex_index_map_generator.get()));
+	local_breadth_first_search(reverse_graph, vertex, vertex_recorder);
 
 	if (!itself)
 	    ret.erase(remove(ret.begin(), ret.end(), vertex), ret.end());
@@ -719,6 +1121,48 @@ namespace storage
     };
 
 
+    namespace
+    {
+
+	void
+	load_device(Devicegraph* devicegraph, const string& classname, const xmlNode* device_node)
+	{
+	    map<string, device_load_fnc>::const_iterator it = device_load_registry.find(classname);
+	    if (it == device_load_registry.end())
+		ST_THROW(Exception(sformat("unknown device class name %s", classname)));
+
+	    const Device* device = it->second(devicegraph, device_node);
+	    Device::Impl::raise_global_sid(device->get_sid());
+	}
+
+
+	void
+	load_holder(Devicegraph* devicegraph, const string& classname, const xmlNode* holder_node)
+	{
+	    map<string, holder_load_fnc>::const_iterator it = holder_load_registry.find(classname);
+	    if (it == holder_load_registry.end())
+		ST_THROW(Exception(sformat("unknown holder class name %s", classname)));
+
+	    it->second(devicegraph, holder_node);
+	}
+
+
+	struct XmlNodeDeleter
+	{
+	    void operator()(xmlNode* node) const { xmlFreeNode(node); }
+	};
+
+	typedef std::unique_ptr<xmlNode, XmlNodeDeleter> xml_node_ptr;
+
+
+	struct XmlReaderDeleter
+	{
+	    void operator()(xmlTextReader* reader) const { xmlFreeTextReader(reader); }
+	};
+
+    }
+
+
     void
     Devicegraph::Impl::load(Devicegraph* devicegraph, const string& filename)
     {
@@ -727,6 +1171,113 @@ namespace storage
 
 	clear();
 
+	if (BinaryFile::is_binary_file(filename))
+	    load_binary(devicegraph, filename);
+	else
+	    load_xml(devicegraph, filename);
+    }
+
+
+    void
+    Devicegraph::Impl::load_with_dom(Devicegraph* devicegraph, const string& filename)
+    {
+	if (&devicegraph->get_impl() != this)
+	    ST_THROW(LogicException("wrong impl-ptr"));
+
+	clear();
+
+	load_xml_dom(devicegraph, filename);
+    }
+
+
+    void
+    Devicegraph::Impl::load_xml(Devicegraph* devicegraph, const string& filename)
+    {
+	// The file is read as a stream. Only the node of the current device
+	// or holder is expanded into a tree and freed again when the reader
+	// moves to the next sibling. So the memory usage does not depend on
+	// the size of the file.
+
+	std::unique_ptr<xmlTextReader, XmlReaderDeleter> reader(
+	    xmlReaderForFile(filename.c_str(), NULL, XML_PARSE_NOBLANKS | XML_PARSE_NONET));
+	if (!reader)
+	    ST_THROW(Exception("failed to load xml document " + filename));
+
+	enum class Section { NONE, DEVICES, HOLDERS };
+
+	Section section = Section::NONE;
+	bool has_devicegraph_node = false;
+
+	int ret = xmlTextReaderRead(reader.get());
+	while (ret == 1)
+	{
+	    if (xmlTextReaderNodeType(reader.get()) != XML_READER_TYPE_ELEMENT)
+	    {
+		ret = xmlTextReaderRead(reader.get());
+		continue;
+	    }
+
+	    const char* name = (const char*) xmlTextReaderConstName(reader.get());
+
+	    switch (xmlTextReaderDepth(reader.get()))
+	    {
+		case 0:
+		{
+		    if (strcmp(name, "Devicegraph") != 0)
+			ST_THROW(Exception("Devicegraph node not found"));
+
+		    has_devicegraph_node = true;
+		    ret = xmlTextReaderRead(reader.get());
+		}
+		break;
+
+		case 1:
+		{
+		    if (strcmp(name, "Devices") == 0)
+			section = Section::DEVICES;
+		    else if (strcmp(name, "Holders") == 0)
+			section = Section::HOLDERS;
+		    else
+			section = Section::NONE;
+
+		    if (section != Section::NONE)
+			ret = xmlTextReaderRead(reader.get());
+		    else
+			ret = xmlTextReaderNext(reader.get());
+		}
+		break;
+
+		default:
+		{
+		    const xmlNode* node = xmlTextReaderExpand(reader.get());
+		    if (!node)
+			ST_THROW(Exception("failed to parse xml document " + filename));
+
+		    if (node->children)
+		    {
+			if (section == Section::DEVICES)
+			    load_device(devicegraph, name, node->children);
+			else if (section == Section::HOLDERS)
+			    load_holder(devicegraph, name, node->children);
+		    }
+
+		    ret = xmlTextReaderNext(reader.get());
+		}
+		break;
+	    }
+	}
+
+	if (ret < 0)
+	    ST_THROW(Exception("failed to parse xml document " + filename));
+
+	if (!has_devicegraph_node)
+	    ST_THROW(Exception("root node not found"));
+    }
+
+
+    void
+    Devicegraph::Impl::load_xml_dom(Devicegraph* devicegraph, const string& filename)
+    {
 	XmlFile xml(filename);
 
 	const xmlNode* root_node = xml.getRootElement();
@@ -741,37 +1292,60 @@ namespace storage
 	if (devices_node)
 	{
 	    for (const xmlNode* device_node : getChildNodes(devices_node))
-	    {
-		const string& classname = (const char*) device_node->parent->name;
-
-		map<string, device_load_fnc>::const_iterator it = device_load_registry.find(classname);
-		if (it == device_load_registry.end())
-		    ST_THROW(Exception(sformat("unknown device class name %s", classname)));
-
-		const Device* device = it->second(devicegraph, device_node);
-		Device::Impl::raise_global_sid(device->get_sid());
-	    }
+		load_device(devicegraph, (const char*) device_node->parent->name, device_node);
 	}
 
 	const xmlNode* holders_node = getChildNode(devicegraph_node, "Holders");
 	if (holders_node)
 	{
 	    for (const xmlNode* holder_node : getChildNodes(holders_node))
-	    {
-		const string& classname = (const char*) holder_node->parent->name;
+		load_holder(devicegraph, (const char*) holder_node->parent->name, holder_node);
+	}
+    }
 
-		map<string, holder_load_fnc>::const_iterator it = holder_load_registry.find(classname);
-		if (it == holder_load_registry.end())
-		    ST_THROW(Exception(sformat("unknown holder class name %s", classname)));
 
-		it->second(devicegraph, holder_node);
-	    }
+    void
+    Devicegraph::Impl::load_binary(Devicegraph* devicegraph, const string& filename)
+    {
+	BinaryFile binary(filename);
+
+	// Every device and holder is converted to a small tree of XML nodes
+	// so that the load functions of the classes can be used.
+
+	for (size_t i = 0; i < binary.num_devices(); ++i)
+	{
+	    xml_node_ptr device_node(binary.get_device_node(i));
+	    if (device_node->children)
+		load_device(devicegraph, binary.get_device_classname(i), device_node->children);
+	}
+
+	for (size_t i = 0; i < binary.num_holders(); ++i)
+	{
+	    xml_node_ptr holder_node(binary.get_holder_node(i));
+	    if (holder_node->children)
+		load_holder(devicegraph, binary.get_holder_classname(i), holder_node->children);
+	}
+    }
+
+
+    void
+    Devicegraph::Impl::save(const string& filename, DevicegraphFormat format) const
+    {
+	switch (format)
+	{
+	    case DevicegraphFormat::XML:
+		save_xml(filename);
+		break;
+
+	    case DevicegraphFormat::BINARY:
+		save_binary(filename);
+		break;
 	}
     }
 
 
     void
-    Devicegraph::Impl::save(const string& filename) const
+    Devicegraph::Impl::save_xml(const string& filename) const
     {
 	XmlFile xml;
 
@@ -804,6 +1378,34 @@ namespace storage
     }
 
 
+    void
+    Devicegraph::Impl::save_binary(const string& filename) const
+    {
+	BinaryFileWriter binary;
+
+	// Only the XML nodes of one device or holder exist at a time.
+
+	for (vertex_descriptor vertex : vertices())
+	{
+	    const Device* device = graph[vertex].get();
+	    xml_node_ptr device_node(xmlNewNode(device->get_impl().get_classname()));
+	    device->save(device_node.get());
+	    binary.add_device(device_node.get());
+	}
+
+	for (edge_descriptor edge : edges())
+	{
+	    const Holder* holder = graph[edge].get();
+	    xml_node_ptr holder_node(xmlNewNode(holder->get_impl().get_classname()));
+	    holder->save(holder_node.get());
+	    binary.add_holder(holder_node.get());
+	}
+
+	if (!binary.save_to_file(filename))
+	    ST_THROW(Exception(sformat("failed to write '%s'", filename)));
+    }
+
+
     void
     Devicegraph::Impl::print(std::ostream& out) const
     {
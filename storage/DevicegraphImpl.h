@@ -26,7 +26,12 @@
 
 
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <typeindex>
+#include <functional>
 #include <boost/noncopyable.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/graph/adjacency_list.hpp>
 
 #include "storage/Devices/Device.h"
@@ -75,13 +80,28 @@ namespace storage
 
 	typedef graph_t::vertices_size_type vertices_size_type;
 
-	Impl(Storage* storage) : storage(storage) {}
+	Impl(Storage* storage) : storage(storage) { touch(); }
 
 	bool operator==(const Impl& rhs) const;
 	bool operator!=(const Impl& rhs) const { return !(*this == rhs); }
 
+	/**
+	 * Check the devicegraph. The checks of the graph structure, the back
+	 * references and the indices are only done for the devices and
+	 * holders added or modified since the last successful check. After
+	 * the graph was cleared, copied or its back references were set the
+	 * complete devicegraph is checked again. The checks of the
+	 * individual devices are always done.
+	 */
 	void check(const CheckCallbacks* check_callbacks) const;
 
+	/**
+	 * The generation is changed whenever the graph, the back references
+	 * or the indices are modified. Generations are unique across all
+	 * devicegraphs, so a devicegraph can be identified by its generation.
+	 */
+	unsigned long get_generation() const { return generation; }
+
 	uint64_t used_features() const;
 
 	void log_diff(std::ostream& log, const Impl& rhs) const;
@@ -117,6 +137,13 @@ namespace storage
 	bool holder_exists(sid_t source_sid, sid_t target_sid) const;
 
 	vertex_descriptor find_vertex(sid_t sid) const;
+
+	/**
+	 * Find the vertex of a device of the devicegraph. Works even while
+	 * several sids are exchanged one after another.
+	 */
+	vertex_descriptor find_vertex(const Device* device) const;
+
 	edge_descriptor find_edge(sid_t source_sid, sid_t target_sid) const;
 
 	vertex_descriptor source(edge_descriptor edge) const { return boost::source(edge, graph); }
@@ -139,7 +166,14 @@ namespace storage
 	boost::iterator_range<edge_iterator> edges() const;
 
 	void load(Devicegraph* devicegraph, const string& filename);
-	void save(const string& filename) const;
+
+	/**
+	 * Load a XML file by building the complete document tree first
+	 * instead of streaming it. Only used for comparison in the
+	 * testsuite.
+	 */
+	void load_with_dom(Devicegraph* devicegraph, const string& filename);
+	void save(const string& filename, DevicegraphFormat format) const;
 
 	void print(std::ostream& out) const;
 
@@ -174,12 +208,29 @@ namespace storage
 	vector<Type*>
 	get_devices_of_type() const
 	{
+	    const type_bucket_t& bucket = get_type_bucket<Type>();
+
 	    vector<Type*> ret;
+	    ret.reserve(bucket.size());
 
-	    for (vertex_descriptor vertex : vertices())
+	    for (const type_bucket_t::value_type& value : bucket)
+		ret.push_back(static_cast<Type*>(graph[value.second].get()));
+
+	    return ret;
+	}
+
+
+
+	template <typename Type, typename Pred>
+	vector<Type*>
+	get_devices_of_type_if(Pred pred) const
+	{
+	    vector<Type*> ret;
+
+	    for (const type_bucket_t::value_type& value : get_type_bucket<Type>())
 	    {
-		Type* device = dynamic_cast<Type*>(graph[vertex].get());
-		if (device)
+		Type* device = static_cast<Type*>(graph[value.second].get());
+		if (pred(device))
 		    ret.push_back(device);
 	    }
 
@@ -187,17 +238,65 @@ namespace storage
 	}
 
 
+	/**
+	 * Find a device of type Type by name using the name index. Returns
+	 * nullptr if no such device exists.
+	 */
+	template <typename Type>
+	Type*
+	find_device_by_name(const string& name) const
+	{
+	    return find_in_string_index<Type>(name_index, name);
+	}
+
+
+	/**
+	 * Find a device of type Type by UUID using the UUID index. Returns
+	 * nullptr if no such device exists.
+	 */
+	template <typename Type>
+	Type*
+	find_device_by_uuid(const string& uuid) const
+	{
+	    return find_in_string_index<Type>(uuid_index, uuid);
+	}
 
-	template <typename Type, typename Pred>
+
+	/**
+	 * Find all devices of type Type by alias using the alias index.
+	 */
+	template <typename Type>
 	vector<Type*>
-	get_devices_of_type_if(Pred pred) const
+	find_devices_by_alias(const string& alias) const
 	{
 	    vector<Type*> ret;
 
-	    for (vertex_descriptor vertex : vertices())
+	    auto range = alias_index.equal_range(alias);
+	    for (string_index_t::const_iterator it = range.first; it != range.second; ++it)
 	    {
-		Type* device = dynamic_cast<Type*>(graph[vertex].get());
-		if (device && pred(device))
+		Type* device = dynamic_cast<Type*>(graph[it->second].get());
+		if (device)
+		    ret.push_back(device);
+	    }
+
+	    return ret;
+	}
+
+
+	/**
+	 * Find all devices of type Type by UUID using the UUID index.
+	 */
+	template <typename Type>
+	vector<Type*>
+	find_devices_by_uuid(const string& uuid) const
+	{
+	    vector<Type*> ret;
+
+	    auto range = uuid_index.equal_range(uuid);
+	    for (string_index_t::const_iterator it = range.first; it != range.second; ++it)
+	    {
+		Type* device = dynamic_cast<Type*>(graph[it->second].get());
+		if (device)
 		    ret.push_back(device);
 	    }
 
@@ -274,7 +373,50 @@ namespace storage
 	}
 
 
-	void swap(Devicegraph::Impl& x);
+	/**
+	 * Exchange the implementations, and thus all devices and holders, of
+	 * the two devicegraphs without copying. Afterwards the back
+	 * references must be adjusted with set_back_references().
+	 */
+	static void swap(Devicegraph& lhs, Devicegraph& rhs);
+
+	/**
+	 * Rebuild the indices from the graph. Must be called after the
+	 * graph was modified without using the functions of this class, e.g.
+	 * by boost::copy_graph.
+	 */
+	void rebuild_indices();
+
+	/**
+	 * Set the back references of all devices and holders to
+	 * devicegraph. Needed after the implementation was swapped with the
+	 * implementation of another devicegraph.
+	 */
+	void set_back_references(Devicegraph* devicegraph);
+
+	/**
+	 * Update the sid indices after the sid of the device at vertex was
+	 * changed from old_sid.
+	 */
+	void update_sid_indices(vertex_descriptor vertex, sid_t old_sid);
+
+	/**
+	 * Update the name index after the name of the device at vertex was
+	 * changed from old_name.
+	 */
+	void update_name_index(vertex_descriptor vertex, const string& old_name);
+
+	/**
+	 * Update the UUID index after the UUID of the device at vertex was
+	 * changed from old_uuid.
+	 */
+	void update_uuid_index(vertex_descriptor vertex, const string& old_uuid);
+
+	/**
+	 * Update the alias index after the aliases of the device at vertex
+	 * were changed from old_aliases.
+	 */
+	void update_alias_index(vertex_descriptor vertex, const vector<string>& old_aliases);
 
 	Storage* get_storage() { return storage; }
 	const Storage* get_storage() const { return storage; }
@@ -283,8 +425,134 @@ namespace storage
 
     private:
 
+	void load_xml(Devicegraph* devicegraph, const string& filename);
+	void load_xml_dom(Devicegraph* devicegraph, const string& filename);
+	void load_binary(Devicegraph* devicegraph, const string& filename);
+
+	void save_xml(const string& filename) const;
+	void save_binary(const string& filename) const;
+
 	Storage* storage;
 
+	unsigned long generation;
+
+	// generation of the last successful check
+	mutable unsigned long checked_generation = 0;
+
+	void touch();
+
+	// Devices and holders, by sids, added or modified since the last
+	// successful check. If check_all is set the complete graph must be
+	// checked.
+
+	mutable bool check_all = true;
+	mutable set<sid_t> unchecked_devices;
+	mutable set<pair<sid_t, sid_t>> unchecked_holders;
+
+	void mark_unchecked(vertex_descriptor vertex);
+	void mark_unchecked(edge_descriptor edge);
+	void mark_all_unchecked();
+
+	void check_graph() const;
+	void check_unchecked() const;
+
+	void check_back_references(vertex_descriptor vertex) const;
+	void check_back_references(edge_descriptor edge) const;
+	void check_string_indices(vertex_descriptor vertex) const;
+
+	// Indices to find vertices and edges by sids in constant time. Both are
+	// kept in sync with the graph by the functions of this class.
+
+	typedef std::unordered_map<sid_t, vertex_descriptor> vertex_index_t;
+	typedef std::unordered_map<pair<sid_t, sid_t>, edge_descriptor,
+				   boost::hash<pair<sid_t, sid_t>>> edge_index_t;
+
+	vertex_index_t vertex_index;
+	edge_index_t edge_index;
+
+	void add_to_edge_index(edge_descriptor edge);
+	void remove_from_edge_index(edge_descriptor edge);
+
+	// Secondary indices to find devices by name, UUID and alias. Several
+	// devices may have the same name, UUID or alias, e.g. a BlkFilesystem
+	// on several devices or temporarily during renames.
+
+	typedef std::unordered_multimap<string, vertex_descriptor> string_index_t;
+
+	string_index_t name_index;
+	string_index_t uuid_index;
+	string_index_t alias_index;
+
+	void add_to_string_index(string_index_t& index, const string& key, vertex_descriptor vertex);
+	void remove_from_string_index(string_index_t& index, const string& key, vertex_descriptor vertex);
+
+	template <typename Type>
+	Type*
+	find_in_string_index(const string_index_t& index, const string& key) const
+	{
+	    auto range = index.equal_range(key);
+	    for (string_index_t::const_iterator it = range.first; it != range.second; ++it)
+	    {
+		Type* device = dynamic_cast<Type*>(graph[it->second].get());
+		if (device)
+		    return device;
+	    }
+
+	    return nullptr;
+	}
+
+	// Position of every vertex in the order of the graph. Used to keep the
+	// buckets of the type index in the order of the graph.
+
+	typedef std::unordered_map<vertex_descriptor, unsigned long> vertex_positions_t;
+
+	vertex_positions_t vertex_positions;
+	unsigned long next_vertex_position = 0;
+
+	// Index of devices by class. A bucket is created on the first query
+	// for a type and afterwards updated when vertices are added or
+	// removed. The vertices in a bucket are keyed by their position so
+	// that removing a vertex does not need a linear search. Buckets are
+	// created by const functions but, like the rest of the devicegraph,
+	// the index is not guarded: the library is not thread-safe and when
+	// actions are committed by several threads the library code is
+	// serialized by the LibraryLock.
+
+	typedef std::map<unsigned long, vertex_descriptor> type_bucket_t;
+
+	struct TypeBucket
+	{
+	    std::function<bool(const Device*)> is_of_type;
+	    type_bucket_t vertices;
+	};
+
+	typedef std::map<std::type_index, TypeBucket> type_index_t;
+
+	mutable type_index_t type_index;
+
+	template <typename Type>
+	const type_bucket_t&
+	get_type_bucket() const
+	{
+	    type_index_t::iterator it = type_index.find(std::type_index(typeid(Type)));
+	    if (it != type_index.end())
+		return it->second.vertices;
+
+	    TypeBucket& bucket = type_index[std::type_index(typeid(Type))];
+
+	    bucket.is_of_type = [](const Device* device) {
+		return dynamic_cast<const Type*>(device) != nullptr;
+	    };
+
+	    for (vertex_descriptor vertex : vertices())
+	    {
+		if (bucket.is_of_type(graph[vertex].get()))
+		    bucket.vertices.emplace_hint(bucket.vertices.end(), vertex_positions.at(vertex), vertex);
+	    }
+
+	    return bucket.vertices;
+	}
+
     };
 
 }
@@ -64,7 +64,7 @@ namespace storage
     Bcache*
     Bcache::clone() const
     {
-	return new Bcache(get_impl().clone());
+	return new Bcache(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
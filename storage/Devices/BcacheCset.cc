@@ -58,7 +58,7 @@ namespace storage
     BcacheCset*
     BcacheCset::clone() const
     {
-	return new BcacheCset(get_impl().clone());
+	return new BcacheCset(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
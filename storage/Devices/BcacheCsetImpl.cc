@@ -58,6 +58,17 @@ namespace storage
     }
 
 
+    void
+    BcacheCset::Impl::set_uuid(const string& uuid)
+    {
+	string old_uuid = Impl::uuid;
+
+	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
+    }
+
+
     string
     BcacheCset::Impl::get_pretty_classname() const
     {
@@ -278,7 +289,7 @@ namespace storage
 
 	    if (regex_match(line, match, set_uuid_regex) && match.size() == 2)
 	    {
-		uuid = match[1];
+		set_uuid(match[1]);
 		y2mil("found set-uuid " << uuid);
 		break;
 	    }
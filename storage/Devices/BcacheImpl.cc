@@ -520,26 +520,8 @@ namespace storage
 
 	AllActions all_actions;
 
-	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.vertices())
-	{
-	    const Action::Base* action = actiongraph[vertex];
-
-	    const Action::Create* create_action = dynamic_cast<const Action::Create*>(action);
-	    if (create_action)
-	    {
-		const Device* device = create_action->get_device(actiongraph);
-		if (is_bcache(device))
-		    all_actions.create_actions.push_back(vertex);
-	    }
-
-	    const Action::Delete* delete_action = dynamic_cast<const Action::Delete*>(action);
-	    if (delete_action)
-	    {
-		const Device* device = delete_action->get_device(actiongraph);
-		if (is_bcache(device))
-		    all_actions.delete_actions.push_back(vertex);
-	    }
-	}
+	all_actions.create_actions = actiongraph.actions_of_type<Action::Create, Bcache>();
+	all_actions.delete_actions = actiongraph.actions_of_type<Action::Delete, Bcache>();
 
 	// Some functions used for sorting actions by bcache number.
 
@@ -21,6 +21,10 @@
  */
 
 
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <chrono>
 #include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 
@@ -30,6 +34,7 @@
 #include "storage/Utils/StorageDefines.h"
 #include "storage/Utils/SystemCmd.h"
 #include "storage/Utils/Mockup.h"
+#include "storage/Utils/LibraryLock.h"
 #include "storage/Devices/BlkDeviceImpl.h"
 #include "storage/Devices/LuksImpl.h"
 #include "storage/Devices/BcacheImpl.h"
@@ -111,6 +116,8 @@ namespace storage
 	{
 	    const CmdUdevadmInfo& cmdudevadminfo = prober.get_system_info().getCmdUdevadmInfo(name);
 
+	    vector<string> old_aliases = get_index_aliases();
+
 	    sysfs_name = cmdudevadminfo.get_name();
 	    sysfs_path = cmdudevadminfo.get_path();
 
@@ -127,6 +134,8 @@ namespace storage
 		udev_ids = cmdudevadminfo.get_by_id_links();
 		process_udev_ids(udev_ids);
 	    }
+
+	    aliases_index_changed(old_aliases);
 	}
     }
 
@@ -201,7 +210,76 @@ namespace storage
     void
     BlkDevice::Impl::set_name(const string& name)
     {
+	string old_name = Impl::name;
+
 	Impl::name = name;
+
+	name_index_changed(old_name);
+    }
+
+
+    vector<string>
+    BlkDevice::Impl::get_index_aliases() const
+    {
+	vector<string> ret;
+
+	if (!sysfs_name.empty())
+	    ret.push_back(DEV_DIR "/" + sysfs_name);
+
+	if (!sysfs_path.empty())
+	    ret.push_back(sysfs_path);
+
+	for (const string& udev_path : udev_paths)
+	    ret.push_back(DEV_DISK_BY_PATH_DIR "/" + udev_path);
+
+	for (const string& udev_id : udev_ids)
+	    ret.push_back(DEV_DISK_BY_ID_DIR "/" + udev_id);
+
+	return ret;
+    }
+
+
+    void
+    BlkDevice::Impl::set_sysfs_name(const string& sysfs_name)
+    {
+	vector<string> old_aliases = get_index_aliases();
+
+	Impl::sysfs_name = sysfs_name;
+
+	aliases_index_changed(old_aliases);
+    }
+
+
+    void
+    BlkDevice::Impl::set_sysfs_path(const string& sysfs_path)
+    {
+	vector<string> old_aliases = get_index_aliases();
+
+	Impl::sysfs_path = sysfs_path;
+
+	aliases_index_changed(old_aliases);
+    }
+
+
+    void
+    BlkDevice::Impl::set_udev_paths(const vector<string>& udev_paths)
+    {
+	vector<string> old_aliases = get_index_aliases();
+
+	Impl::udev_paths = udev_paths;
+
+	aliases_index_changed(old_aliases);
+    }
+
+
+    void
+    BlkDevice::Impl::set_udev_ids(const vector<string>& udev_ids)
+    {
+	vector<string> old_aliases = get_index_aliases();
+
+	Impl::udev_ids = udev_ids;
+
+	aliases_index_changed(old_aliases);
     }
 
 
@@ -318,43 +396,65 @@ namespace storage
     }
 
 
-    bool
-    BlkDevice::Impl::exists_by_any_name(const Devicegraph* devicegraph, const string& name,
-					SystemInfo& system_info)
+    namespace
     {
-	if (!devicegraph->get_impl().is_system() && !devicegraph->get_impl().is_probed())
-	    ST_THROW(Exception("function called on wrong devicegraph"));
 
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
+	/**
+	 * Finds an active block device by name, kernel name, udev link or
+	 * sysfs path using the indices of the devicegraph. Only if that fails
+	 * udev is queried for the sysfs path, during probing usually from the
+	 * already loaded udev database. Returns nullptr if no block device is
+	 * found.
+	 */
+	template <typename Type>
+	Type*
+	find_blk_device_by_any_name(const Devicegraph* devicegraph, const string& name,
+				    SystemInfo& system_info)
 	{
-	    const BlkDevice* blk_device = dynamic_cast<const BlkDevice*>(devicegraph->get_impl()[vertex]);
-	    if (blk_device)
-	    {
-		if (blk_device->get_name() == name)
-		    return true;
-	    }
-	}
+	    const Devicegraph::Impl& impl = devicegraph->get_impl();
 
-	try
-	{
-	    string sysfs_path = system_info.getCmdUdevadmInfo(name).get_path();
+	    if (!impl.is_system() && !impl.is_probed())
+		ST_THROW(Exception("function called on wrong devicegraph"));
 
-	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	    {
-		const BlkDevice* blk_device = dynamic_cast<const BlkDevice*>(devicegraph->get_impl()[vertex]);
-		if (blk_device && blk_device->get_impl().active)
+	    Type* blk_device = impl.find_device_by_name<Type>(name);
+	    if (blk_device)
+		return blk_device;
+
+	    auto find_active_by_alias = [&impl](const string& alias) -> Type* {
+		for (Type* blk_device : impl.find_devices_by_alias<Type>(alias))
 		{
-		    if (blk_device->get_sysfs_path() == sysfs_path)
-			return true;
+		    if (blk_device->get_impl().is_active())
+			return blk_device;
 		}
+		return nullptr;
+	    };
+
+	    blk_device = find_active_by_alias(name);
+	    if (blk_device)
+		return blk_device;
+
+	    try
+	    {
+		string sysfs_path = system_info.getCmdUdevadmInfo(name).get_path();
+
+		blk_device = find_active_by_alias(sysfs_path);
 	    }
-	}
-	catch (const Exception& exception)
-	{
-	    ST_CAUGHT(exception);
+	    catch (const Exception& exception)
+	    {
+		ST_CAUGHT(exception);
+	    }
+
+	    return blk_device;
 	}
 
-	return false;
+    }
+
+
+    bool
+    BlkDevice::Impl::exists_by_any_name(const Devicegraph* devicegraph, const string& name,
+					SystemInfo& system_info)
+    {
+	return find_blk_device_by_any_name<const BlkDevice>(devicegraph, name, system_info);
     }
 
 
@@ -362,39 +462,11 @@ namespace storage
     BlkDevice::Impl::find_by_any_name(Devicegraph* devicegraph, const string& name,
 				      SystemInfo& system_info)
     {
-	if (!devicegraph->get_impl().is_system() && !devicegraph->get_impl().is_probed())
-	    ST_THROW(Exception("function called on wrong devicegraph"));
-
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    BlkDevice* blk_device = dynamic_cast<BlkDevice*>(devicegraph->get_impl()[vertex]);
-	    if (blk_device)
-	    {
-		if (blk_device->get_name() == name)
-		    return blk_device;
-	    }
-	}
-
-	try
-	{
-	    string sysfs_path = system_info.getCmdUdevadmInfo(name).get_path();
-
-	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	    {
-		BlkDevice* blk_device = dynamic_cast<BlkDevice*>(devicegraph->get_impl()[vertex]);
-		if (blk_device && blk_device->get_impl().active)
-		{
-		    if (blk_device->get_sysfs_path() == sysfs_path)
-			return blk_device;
-		}
-	    }
-	}
-	catch (const Exception& exception)
-	{
-	    ST_CAUGHT(exception);
-	}
+	BlkDevice* blk_device = find_blk_device_by_any_name<BlkDevice>(devicegraph, name, system_info);
+	if (!blk_device)
+	    ST_THROW(DeviceNotFoundByName(name));
 
-	ST_THROW(DeviceNotFoundByName(name));
+	return blk_device;
     }
 
 
@@ -402,39 +474,12 @@ namespace storage
     BlkDevice::Impl::find_by_any_name(const Devicegraph* devicegraph, const string& name,
 				      SystemInfo& system_info)
     {
-	if (!devicegraph->get_impl().is_system() && !devicegraph->get_impl().is_probed())
-	    ST_THROW(Exception("function called on wrong devicegraph"));
-
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    const BlkDevice* blk_device = dynamic_cast<const BlkDevice*>(devicegraph->get_impl()[vertex]);
-	    if (blk_device)
-	    {
-		if (blk_device->get_name() == name)
-		    return blk_device;
-	    }
-	}
-
-	try
-	{
-	    string sysfs_path = system_info.getCmdUdevadmInfo(name).get_path();
+	const BlkDevice* blk_device = find_blk_device_by_any_name<const BlkDevice>(devicegraph, name,
+										  system_info);
+	if (!blk_device)
+	    ST_THROW(DeviceNotFoundByName(name));
 
-	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	    {
-		const BlkDevice* blk_device = dynamic_cast<const BlkDevice*>(devicegraph->get_impl()[vertex]);
-		if (blk_device && blk_device->get_impl().active)
-		{
-		    if (blk_device->get_sysfs_path() == sysfs_path)
-			return blk_device;
-		}
-	    }
-	}
-	catch (const Exception& exception)
-	{
-	    ST_CAUGHT(exception);
-	}
-
-	ST_THROW(DeviceNotFoundByName(name));
+	return blk_device;
     }
 
 
@@ -869,36 +914,123 @@ namespace storage
     }
 
 
-    void
-    wait_for_devices(const vector<const BlkDevice*>& blk_devices)
+    namespace
     {
-	SystemCmd(UDEVADMBIN_SETTLE);
 
-	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
-	    return;
+	bool
+	exists_device_node(const string& name)
+	{
+	    return access(name.c_str(), R_OK) == 0;
+	}
 
-	for (const BlkDevice* blk_device : blk_devices)
+
+	/**
+	 * Waits until all device nodes exist (or do not exist if exist is
+	 * false). The directories of the device nodes are watched with
+	 * inotify so that the function returns as soon as the last device
+	 * node appeared or disappeared. The timeout of 5 seconds applies to
+	 * all device nodes together.
+	 */
+	void
+	wait_for_device_nodes(const vector<string>& names, bool exist, const string& func)
 	{
-	    string name = blk_device->get_name();
+	    SystemCmd(UDEVADMBIN_SETTLE);
+
+	    if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
+		return;
+
+	    const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+		chrono::seconds(5);
+
+	    // Without inotify fall back to polling every 10 ms. With inotify
+	    // still check every 100 ms in case an event is missed, e.g. for a
+	    // directory created between checking and watching it.
+
+	    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	    if (fd < 0)
+		y2war("inotify_init1 failed, errno:" << errno);
 
-	    bool exists = access(name.c_str(), R_OK) == 0;
-	    y2mil("name:" << name << " exists:" << exists);
+	    vector<string> pending = names;
 
-	    if (!exists)
+	    while (true)
 	    {
-		for (int count = 0; count < 500; ++count)
+		// Watch before checking to not miss events in between. The
+		// parent directories are also watched since e.g. /dev/system
+		// of /dev/system/root may not exist yet.
+
+		if (fd >= 0)
+		{
+		    for (const string& name : pending)
+		    {
+			for (string dir = dirname(name); dir.size() > 1; dir = dirname(dir))
+			{
+			    inotify_add_watch(fd, dir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+					      IN_MOVED_TO | IN_ATTRIB | IN_ONLYDIR);
+			}
+		    }
+		}
+
+		pending.erase(remove_if(pending.begin(), pending.end(), [exist](const string& name) {
+		    return exists_device_node(name) == exist;
+		}), pending.end());
+
+		if (pending.empty())
+		    break;
+
+		chrono::steady_clock::duration remaining = deadline - chrono::steady_clock::now();
+		if (remaining <= chrono::steady_clock::duration::zero())
+		    break;
+
+		int timeout = min<long>(chrono::duration_cast<chrono::milliseconds>(remaining).count() + 1,
+					fd >= 0 ? 100 : 10);
+
+		{
+		    LibraryLock::Unlock unlock;
+
+		    if (fd >= 0)
+		    {
+			struct pollfd pfd = { fd, POLLIN, 0 };
+			poll(&pfd, 1, timeout);
+		    }
+		    else
+		    {
+			usleep(timeout * 1000);
+		    }
+		}
+
+		if (fd >= 0)
 		{
-		    usleep(10000);
-		    exists = access(name.c_str(), R_OK) == 0;
-		    if (exists)
-			break;
+		    char buf[4096];
+		    while (read(fd, buf, sizeof(buf)) > 0)
+			;
 		}
-		y2mil("name:" << name << " exists:" << exists);
 	    }
 
-	    if (!exists)
-		ST_THROW(Exception("wait_for_devices failed " + name));
+	    if (fd >= 0)
+		close(fd);
+
+	    for (const string& name : names)
+	    {
+		bool done = find(pending.begin(), pending.end(), name) == pending.end();
+		y2mil("name:" << name << " exists:" << (done == exist));
+	    }
+
+	    if (!pending.empty())
+		ST_THROW(Exception(func + " failed " + pending.front()));
 	}
+
+    }
+
+
+    void
+    wait_for_devices(const vector<const BlkDevice*>& blk_devices)
+    {
+	vector<string> dev_names;
+
+	for (const BlkDevice* blk_device : blk_devices)
+	    dev_names.push_back(blk_device->get_name());
+
+	wait_for_device_nodes(dev_names, true, "wait_for_devices");
     }
 
 
@@ -919,37 +1051,7 @@ namespace storage
     void
     wait_for_detach_devices(const vector<string>& dev_names)
     {
-	SystemCmd(UDEVADMBIN_SETTLE);
-
-	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
-	    return;
-
-	for (auto name : dev_names)
-	{
-	    bool exists = access(name.c_str(), R_OK) == 0;
-
-	    y2mil("name:" << name << " exists:" << exists);
-
-	    if (exists)
-	    {
-		// Waits a max of 5 seconds
-		for (int count = 0; count < 500; ++count)
-		{
-		    if((count % 100) == 0)
-			y2mil("waiting for detach " << name);
-
-		    usleep(10000);
-		    exists = access(name.c_str(), R_OK) == 0;
-		    if (!exists)
-			break;
-		}
-
-		y2mil("name:" << name << " exists:" << exists);
-	    }
-
-	    if (exists)
-		ST_THROW(Exception("wait_for_detach_devices failed " + name));
-	}
+	wait_for_device_nodes(dev_names, false, "wait_for_detach_devices");
     }
 
 
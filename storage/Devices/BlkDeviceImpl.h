@@ -59,6 +59,10 @@ namespace storage
 
 	virtual string get_sort_key() const override { return get_name(); }
 
+	virtual string get_index_name() const override { return get_name(); }
+
+	virtual vector<string> get_index_aliases() const override;
+
 	virtual void check(const CheckCallbacks* check_callbacks) const override;
 
 	virtual bool is_usable_as_blk_device() const { return true; }
@@ -67,10 +71,10 @@ namespace storage
 	void set_name(const string& name);
 
 	const string& get_sysfs_name() const { return sysfs_name; }
-	void set_sysfs_name(const string& sysfs_name) { Impl::sysfs_name = sysfs_name; }
+	void set_sysfs_name(const string& sysfs_name);
 
 	const string& get_sysfs_path() const { return sysfs_path; }
-	void set_sysfs_path(const string& sysfs_path) { Impl::sysfs_path = sysfs_path; }
+	void set_sysfs_path(const string& sysfs_path);
 
 	const File& get_sysfs_file(SystemInfo& system_info, const char* filename) const;
 
@@ -97,10 +101,10 @@ namespace storage
 	void set_topology(const Topology& topology) { Impl::topology = topology; }
 
 	const vector<string>& get_udev_paths() const { return udev_paths; }
-	void set_udev_paths(const vector<string>& udev_paths) { Impl::udev_paths = udev_paths; }
+	void set_udev_paths(const vector<string>& udev_paths);
 
 	const vector<string>& get_udev_ids() const { return udev_ids; }
-	void set_udev_ids(const vector<string>& udev_ids) { Impl::udev_ids = udev_ids; }
+	void set_udev_ids(const vector<string>& udev_ids);
 
 	string get_mount_by_name(MountByType mount_by_type) const;
 
@@ -232,13 +236,15 @@ namespace storage
 
 
     /**
-     * Run "udevadm settle" and check existence of all blk devices.
+     * Run "udevadm settle" and wait until all blk devices exist. Waits
+     * at most 5 seconds for all blk devices together.
      */
     void wait_for_devices(const vector<const BlkDevice*>& blk_devices);
 
 
     /**
-     * Run "udevadm settle" and check non existence of all blk devices.
+     * Run "udevadm settle" and wait until no blk device exists. Waits at
+     * most 5 seconds for all blk devices together.
      */
     void wait_for_detach_devices(const vector<const BlkDevice*>& blk_devices);
     void wait_for_detach_devices(const vector<string>& dev_names);
@@ -80,7 +80,7 @@ namespace storage
     Dasd*
     Dasd::clone() const
     {
-	return new Dasd(get_impl().clone());
+	return new Dasd(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
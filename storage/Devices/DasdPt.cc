@@ -58,7 +58,7 @@ namespace storage
     DasdPt*
     DasdPt::clone() const
     {
-	return new DasdPt(get_impl().clone());
+	return new DasdPt(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
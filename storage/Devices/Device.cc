@@ -42,9 +42,23 @@ namespace storage
 
 
     Device::Device(Impl* impl)
-	: impl(impl)
+	: impl(), shared_impl(false), shared_devicegraph(nullptr)
     {
 	ST_CHECK_PTR(impl);
+
+	// An implementation already owned by another device is shared, see
+	// clone().
+
+	Device::impl = impl->self.lock();
+	if (Device::impl)
+	{
+	    shared_impl = true;
+	}
+	else
+	{
+	    Device::impl.reset(impl);
+	    impl->self = Device::impl;
+	}
     }
 
 
@@ -63,6 +77,9 @@ namespace storage
     bool
     Device::operator==(const Device& rhs) const
     {
+	if (impl == rhs.impl)
+	    return true;
+
 	return get_impl().operator==(rhs.get_impl());
     }
 
@@ -70,7 +87,7 @@ namespace storage
     bool
     Device::operator!=(const Device& rhs) const
     {
-	return get_impl().operator!=(rhs.get_impl());
+	return !(*this == rhs);
     }
 
 
@@ -134,6 +151,28 @@ namespace storage
     }
 
 
+    void
+    Device::unshare_impl() const
+    {
+	shared_ptr<Impl> tmp(impl->clone());
+	tmp->self = tmp;
+	impl = tmp;
+
+	if (!shared_impl)
+	    return;
+
+	shared_impl = false;
+
+	if (shared_devicegraph)
+	{
+	    Devicegraph* devicegraph = shared_devicegraph;
+	    shared_devicegraph = nullptr;
+
+	    impl->set_devicegraph_and_vertex(devicegraph, devicegraph->get_impl().find_vertex(this));
+	}
+    }
+
+
     void
     Device::save(xmlNode* node) const
     {
@@ -144,7 +183,7 @@ namespace storage
     sid_t
     Device::get_sid() const
     {
-	return get_impl().get_sid();
+	return impl->get_sid();
     }
 
 
@@ -203,8 +203,12 @@ namespace storage
 
 	class Impl;
 
-	Impl& get_impl() { return *impl; }
-	const Impl& get_impl() const { return *impl; }
+	/**
+	 * Clones of the device share the implementation until it is used or
+	 * modified, so the implementation is cloned here if needed.
+	 */
+	Impl& get_impl() { if (shared_impl || impl.use_count() > 1) unshare_impl(); return *impl; }
+	const Impl& get_impl() const { if (shared_impl) unshare_impl(); return *impl; }
 
 	virtual Device* clone() const = 0;
 
@@ -214,6 +218,12 @@ namespace storage
 
 	Device(Impl* impl);
 
+	/**
+	 * Returns the implementation without unsharing it. Used by clone() to
+	 * make a clone sharing the implementation.
+	 */
+	Impl& get_shared_impl() const { return *impl; }
+
 	void create(Devicegraph* devicegraph);
 	void load(Devicegraph* devicegraph);
 
@@ -221,7 +231,26 @@ namespace storage
 
 	void add_to_devicegraph(Devicegraph* devicegraph);
 
-	const std::unique_ptr<Impl> impl;
+	/**
+	 * Clones the implementation. If the implementation was shared with
+	 * the device the clone was made from also sets the back references.
+	 */
+	void unshare_impl() const;
+
+	mutable std::shared_ptr<Impl> impl;
+
+	/**
+	 * Whether the implementation is shared with the device the clone was
+	 * made from. The back references of the implementation then still
+	 * point to that device.
+	 */
+	mutable bool shared_impl;
+
+	/**
+	 * The devicegraph the clone was added to while the implementation is
+	 * shared.
+	 */
+	mutable Devicegraph* shared_devicegraph;
 
     };
 
@@ -57,6 +57,12 @@ namespace storage
     }
 
 
+    Device::Impl::Impl(const Impl& impl)
+	: sid(impl.sid), devicegraph(impl.devicegraph), vertex(impl.vertex), userdata(impl.userdata)
+    {
+    }
+
+
     bool
     Device::Impl::operator==(const Impl& rhs) const
     {
@@ -76,7 +82,7 @@ namespace storage
 	Device* device = get_non_impl()->clone();
 
 	Devicegraph::Impl::vertex_descriptor vertex = devicegraph->get_impl().add_vertex(device);
-	device->get_impl().set_devicegraph_and_vertex(devicegraph, vertex);
+	set_back_references(device, devicegraph, vertex);
 
 	return device;
     }
@@ -161,6 +167,49 @@ namespace storage
     }
 
 
+    void
+    Device::Impl::set_sid(sid_t sid)
+    {
+	sid_t old_sid = Impl::sid;
+
+	Impl::sid = sid;
+
+	if (has_valid_back_references())
+	    devicegraph->get_impl().update_sid_indices(vertex, old_sid);
+    }
+
+
+    bool
+    Device::Impl::has_valid_back_references() const
+    {
+	return devicegraph && &devicegraph->get_impl()[vertex]->get_impl() == this;
+    }
+
+
+    void
+    Device::Impl::name_index_changed(const string& old_name)
+    {
+	if (has_valid_back_references())
+	    devicegraph->get_impl().update_name_index(vertex, old_name);
+    }
+
+
+    void
+    Device::Impl::uuid_index_changed(const string& old_uuid)
+    {
+	if (has_valid_back_references())
+	    devicegraph->get_impl().update_uuid_index(vertex, old_uuid);
+    }
+
+
+    void
+    Device::Impl::aliases_index_changed(const vector<string>& old_aliases)
+    {
+	if (has_valid_back_references())
+	    devicegraph->get_impl().update_alias_index(vertex, old_aliases);
+    }
+
+
     void
     Device::Impl::set_devicegraph_and_vertex(Devicegraph* devicegraph,
 					     Devicegraph::Impl::vertex_descriptor vertex)
@@ -174,6 +223,31 @@ namespace storage
     }
 
 
+    void
+    Device::Impl::set_back_references(Device* device, Devicegraph* devicegraph,
+				      Devicegraph::Impl::vertex_descriptor vertex)
+    {
+	if (device->shared_impl)
+	{
+	    if (devicegraph->get_impl()[vertex] != device)
+		ST_THROW(LogicException("wrong vertex for back references"));
+
+	    device->shared_devicegraph = devicegraph;
+	}
+	else
+	{
+	    device->impl->set_devicegraph_and_vertex(devicegraph, vertex);
+	}
+    }
+
+
+    const Devicegraph*
+    Device::Impl::get_shared_devicegraph(const Device* device)
+    {
+	return device->shared_impl ? device->shared_devicegraph : nullptr;
+    }
+
+
     Devicegraph*
     Device::Impl::get_devicegraph()
     {
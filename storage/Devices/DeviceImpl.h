@@ -95,6 +95,20 @@ namespace storage
 
 	virtual string get_sort_key() const { return ""; }
 
+	/**
+	 * Name and UUID used for the lookup indices of the devicegraph, see
+	 * find_by_name() and find_by_uuid(). Empty if the class has no name
+	 * or UUID.
+	 */
+	virtual string get_index_name() const { return ""; }
+	virtual string get_index_uuid() const { return ""; }
+
+	/**
+	 * Further names used for the alias index of the devicegraph, e.g.
+	 * kernel names, udev links and sysfs paths of block devices.
+	 */
+	virtual vector<string> get_index_aliases() const { return {}; }
+
 	virtual void save(xmlNode* node) const = 0;
 
 	virtual void check(const CheckCallbacks* check_callbacks) const;
@@ -113,11 +127,32 @@ namespace storage
 	const Storage* get_storage() const;
 
 	sid_t get_sid() const { return sid; }
-	void set_sid(sid_t sid) { Impl::sid = sid; }
+	void set_sid(sid_t sid);
 
 	void set_devicegraph_and_vertex(Devicegraph* devicegraph,
 					Devicegraph::Impl::vertex_descriptor vertex);
 
+	/**
+	 * Sets the back references of the device. Unlike
+	 * set_devicegraph_and_vertex() this does not unshare the
+	 * implementation of a clone, see Device::get_impl().
+	 */
+	static void set_back_references(Device* device, Devicegraph* devicegraph,
+					Devicegraph::Impl::vertex_descriptor vertex);
+
+	/**
+	 * Returns the devicegraph of a clone still sharing its
+	 * implementation or nullptr otherwise.
+	 */
+	static const Devicegraph* get_shared_devicegraph(const Device* device);
+
+	/**
+	 * Returns the implementation of the device without unsharing it. Only
+	 * functions not using the back references, e.g. get_index_name(), may
+	 * be called on it.
+	 */
+	static const Impl& get_shared_impl(const Device* device) { return *device->impl; }
+
 	Devicegraph* get_devicegraph();
 	const Devicegraph* get_devicegraph() const;
 
@@ -384,6 +419,33 @@ namespace storage
 
 	Impl(const xmlNode* node);
 
+	Impl(const Impl& impl);
+
+	/**
+	 * Check whether the back references point to this object. A clone
+	 * not yet added to a devicegraph still has the back references of
+	 * the original.
+	 */
+	bool has_valid_back_references() const;
+
+	/**
+	 * Must be called after the name returned by get_index_name() was
+	 * changed.
+	 */
+	void name_index_changed(const string& old_name);
+
+	/**
+	 * Must be called after the UUID returned by get_index_uuid() was
+	 * changed.
+	 */
+	void uuid_index_changed(const string& old_uuid);
+
+	/**
+	 * Must be called after the aliases returned by get_index_aliases()
+	 * were changed.
+	 */
+	void aliases_index_changed(const vector<string>& old_aliases);
+
     private:
 
 	/**
@@ -403,6 +465,14 @@ namespace storage
 
 	map<string, string> userdata;
 
+	/**
+	 * The implementation owned by the device, used to share it with
+	 * clones. Not copied when the implementation is cloned.
+	 */
+	std::weak_ptr<Impl> self;
+
+	friend class Device;
+
     };
 
 
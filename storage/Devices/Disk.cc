@@ -85,7 +85,7 @@ namespace storage
     Disk*
     Disk::clone() const
     {
-	return new Disk(get_impl().clone());
+	return new Disk(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -75,7 +75,7 @@ namespace storage
     DmRaid*
     DmRaid::clone() const
     {
-	return new DmRaid(get_impl().clone());
+	return new DmRaid(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
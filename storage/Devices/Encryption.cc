@@ -107,7 +107,7 @@ namespace storage
     Encryption*
     Encryption::clone() const
     {
-	return new Encryption(get_impl().clone());
+	return new Encryption(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -59,7 +59,7 @@ namespace storage
     Gpt*
     Gpt::clone() const
     {
-	return new Gpt(get_impl().clone());
+	return new Gpt(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     ImplicitPt*
     ImplicitPt::clone() const
     {
-	return new ImplicitPt(get_impl().clone());
+	return new ImplicitPt(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     Luks*
     Luks::clone() const
     {
-	return new Luks(get_impl().clone());
+	return new Luks(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -553,8 +553,7 @@ namespace storage
 	entry->set_crypt_opts(get_crypt_options());
 
 	etc_crypttab.add(entry);
-	etc_crypttab.log();
-	etc_crypttab.write();
+	commit_data.write_etc_crypttab();
     }
 
 
@@ -567,8 +566,7 @@ namespace storage
 	if (entry)
 	{
 	    entry->set_block_device(get_mount_by_name(get_mount_by()));
-	    etc_crypttab.log();
-	    etc_crypttab.write();
+	    commit_data.write_etc_crypttab();
 	}
     }
 
@@ -582,8 +580,7 @@ namespace storage
 	if (entry)
 	{
 	    etc_crypttab.remove(entry);
-	    etc_crypttab.log();
-	    etc_crypttab.write();
+	    commit_data.write_etc_crypttab();
 	}
     }
 
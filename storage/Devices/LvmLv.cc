@@ -66,7 +66,7 @@ namespace storage
     LvmLv*
     LvmLv::clone() const
     {
-	return new LvmLv(get_impl().clone());
+	return new LvmLv(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
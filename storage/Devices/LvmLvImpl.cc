@@ -527,6 +527,17 @@ namespace storage
     }
 
 
+    void
+    LvmLv::Impl::set_uuid(const string& uuid)
+    {
+	string old_uuid = Impl::uuid;
+
+	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
+    }
+
+
     LvmLv*
     LvmLv::Impl::find_by_uuid(Devicegraph* devicegraph, const string& uuid)
     {
@@ -85,7 +85,9 @@ namespace storage
 	LvType get_lv_type() const { return lv_type; }
 
 	const string& get_uuid() const { return uuid; }
-	void set_uuid(const string& uuid) { Impl::uuid = uuid; }
+	void set_uuid(const string& uuid);
+
+	virtual string get_index_uuid() const override { return uuid; }
 
 	unsigned long long number_of_extents() const { return get_region().get_length(); }
 
@@ -59,7 +59,7 @@ namespace storage
     LvmPv*
     LvmPv::clone() const
     {
-	return new LvmPv(get_impl().clone());
+	return new LvmPv(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -251,6 +251,17 @@ namespace storage
     }
 
 
+    void
+    LvmPv::Impl::set_uuid(const string& uuid)
+    {
+	string old_uuid = Impl::uuid;
+
+	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
+    }
+
+
     LvmPv*
     LvmPv::Impl::find_by_uuid(Devicegraph* devicegraph, const string& uuid)
     {
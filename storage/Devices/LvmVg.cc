@@ -74,7 +74,7 @@ namespace storage
     LvmVg*
     LvmVg::clone() const
     {
-	return new LvmVg(get_impl().clone());
+	return new LvmVg(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -447,6 +447,17 @@ namespace storage
     }
 
 
+    void
+    LvmVg::Impl::set_uuid(const string& uuid)
+    {
+	string old_uuid = Impl::uuid;
+
+	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
+    }
+
+
     LvmVg*
     LvmVg::Impl::find_by_uuid(Devicegraph* devicegraph, const std::string& uuid)
     {
@@ -99,7 +99,9 @@ namespace storage
 	void set_vg_name(const string& vg_name);
 
 	const string& get_uuid() const { return uuid; }
-	void set_uuid(const string& uuid) { Impl::uuid = uuid; }
+	void set_uuid(const string& uuid);
+
+	virtual string get_index_uuid() const override { return uuid; }
 
 	LvmPv* add_lvm_pv(BlkDevice* blk_device);
 	void remove_lvm_pv(BlkDevice* blk_device);
@@ -76,7 +76,7 @@ namespace storage
     Md*
     Md::clone() const
     {
-	return new Md(get_impl().clone());
+	return new Md(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -57,7 +57,7 @@ namespace storage
     MdContainer*
     MdContainer::clone() const
     {
-	return new MdContainer(get_impl().clone());
+	return new MdContainer(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -138,6 +138,17 @@ namespace storage
     }
 
 
+    void
+    Md::Impl::set_uuid(const string& uuid)
+    {
+	string old_uuid = Impl::uuid;
+
+	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
+    }
+
+
     string
     Md::Impl::get_sort_key() const
     {
@@ -439,7 +450,7 @@ namespace storage
 	chunk_size = entry.chunk_size;
 
 	const MdadmDetail& mdadm_detail = prober.get_system_info().getMdadmDetail(get_name());
-	uuid = mdadm_detail.uuid;
+	set_uuid(mdadm_detail.uuid);
 	metadata = mdadm_detail.metadata;
 	md_level = mdadm_detail.level;
 
@@ -519,7 +530,7 @@ namespace storage
     Md::Impl::probe_uuid()
     {
 	MdadmDetail mdadm_detail(get_name());
-	uuid = mdadm_detail.uuid;
+	set_uuid(mdadm_detail.uuid);
     }
 
 
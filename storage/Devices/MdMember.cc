@@ -57,7 +57,7 @@ namespace storage
     MdMember*
     MdMember::clone() const
     {
-	return new MdMember(get_impl().clone());
+	return new MdMember(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -59,7 +59,7 @@ namespace storage
     Msdos*
     Msdos::clone() const
     {
-	return new Msdos(get_impl().clone());
+	return new Msdos(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
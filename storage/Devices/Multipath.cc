@@ -75,7 +75,7 @@ namespace storage
     Multipath*
     Multipath::clone() const
     {
-	return new Multipath(get_impl().clone());
+	return new Multipath(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
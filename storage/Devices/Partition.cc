@@ -72,7 +72,7 @@ namespace storage
     Partition*
     Partition::clone() const
     {
-	return new Partition(get_impl().clone());
+	return new Partition(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
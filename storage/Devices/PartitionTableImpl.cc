@@ -451,79 +451,56 @@ namespace storage
 
 	map<sid_t, AllActions> all_actions_per_partition_table;
 
-	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.vertices())
+	const Devicegraph* devicegraph_rhs = actiongraph.get_devicegraph(RHS);
+	const Devicegraph* devicegraph_lhs = actiongraph.get_devicegraph(LHS);
+
+	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.actions_of_type<Action::Create, Partition>())
 	{
-	    const Action::Base* action = actiongraph[vertex];
+	    const Partition* partition = to_partition(devicegraph_rhs->find_device(actiongraph[vertex]->sid));
+	    sid_t sid = partition->get_partition_table()->get_sid();
 
-	    const Action::Create* create_action = dynamic_cast<const Action::Create*>(action);
-	    if (create_action)
-	    {
-		const Device* device = create_action->get_device(actiongraph);
-		if (is_partition(device))
-		{
-		    const Partition* partition = to_partition(device);
-		    sid_t sid = partition->get_partition_table()->get_sid();
+	    all_actions_per_partition_table[sid].create_actions.push_back(vertex);
+	}
 
-		    all_actions_per_partition_table[sid].create_actions.push_back(vertex);
-		}
-	    }
+	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.actions_of_type<Action::Delete, Partition>())
+	{
+	    const Partition* partition = to_partition(devicegraph_lhs->find_device(actiongraph[vertex]->sid));
+	    sid_t sid = partition->get_partition_table()->get_sid();
 
-	    const Action::Delete* delete_action = dynamic_cast<const Action::Delete*>(action);
-            if (delete_action)
-            {
-                const Device* device = delete_action->get_device(actiongraph);
-                if (is_partition(device))
-                {
-                    const Partition* partition = to_partition(device);
-                    sid_t sid = partition->get_partition_table()->get_sid();
-
-                    all_actions_per_partition_table[sid].delete_actions.push_back(vertex);
-                }
-            }
-
-	    const Action::Resize* resize_action = dynamic_cast<const Action::Resize*>(action);
-	    if (resize_action)
-	    {
-		const Device* device = resize_action->get_device(actiongraph, RHS);
-		if (is_partition(device))
-		{
-		    const Partition* partition = to_partition(device);
-		    sid_t sid = partition->get_partition_table()->get_sid();
+	    all_actions_per_partition_table[sid].delete_actions.push_back(vertex);
+	}
 
-		    if (resize_action->resize_mode == ResizeMode::GROW)
-			all_actions_per_partition_table[sid].grow_actions.push_back(vertex);
-		    else
-			all_actions_per_partition_table[sid].shrink_actions.push_back(vertex);
-		}
-	    }
+	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.actions_of_type<Action::Resize, Partition>())
+	{
+	    const Action::Resize* resize_action = static_cast<const Action::Resize*>(actiongraph[vertex]);
 
-	    const Action::RenameIn* rename_in_action = dynamic_cast<const Action::RenameIn*>(action);
-	    if (rename_in_action)
-	    {
-		const Partition* partition = to_partition(rename_in_action->get_renamed_blk_device(actiongraph, RHS));
-		sid_t sid = partition->get_partition_table()->get_sid();
+	    const Partition* partition = to_partition(resize_action->get_device(actiongraph, RHS));
+	    sid_t sid = partition->get_partition_table()->get_sid();
 
-		all_actions_per_partition_table[sid].rename_in_actions.push_back(vertex);
-	    }
+	    if (resize_action->resize_mode == ResizeMode::GROW)
+		all_actions_per_partition_table[sid].grow_actions.push_back(vertex);
+	    else
+		all_actions_per_partition_table[sid].shrink_actions.push_back(vertex);
+	}
 
-	    const Action::Repair* repair_action = dynamic_cast<const Action::Repair*>(action);
-	    if (repair_action)
-	    {
-		const Device* device = repair_action->get_device(actiongraph, RHS);
-		if (is_partition_table(device))
-		{
-		    const PartitionTable* partition_table = to_partition_table(device);
-		    sid_t sid = partition_table->get_sid();
+	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.actions_of_type<Action::RenameIn>())
+	{
+	    const Action::RenameIn* rename_in_action = static_cast<const Action::RenameIn*>(actiongraph[vertex]);
 
-		    all_actions_per_partition_table[sid].repair_actions.push_back(vertex);
-		}
-	    }
+	    const Partition* partition = to_partition(rename_in_action->get_renamed_blk_device(actiongraph, RHS));
+	    sid_t sid = partition->get_partition_table()->get_sid();
+
+	    all_actions_per_partition_table[sid].rename_in_actions.push_back(vertex);
 	}
 
-	// Some functions used for sorting actions by partition number.
+	for (Actiongraph::Impl::vertex_descriptor vertex : actiongraph.actions_of_type<Action::Repair, PartitionTable>())
+	{
+	    sid_t sid = actiongraph[vertex]->sid;
 
-        const Devicegraph* devicegraph_rhs = actiongraph.get_devicegraph(RHS);
-        const Devicegraph* devicegraph_lhs = actiongraph.get_devicegraph(LHS);
+	    all_actions_per_partition_table[sid].repair_actions.push_back(vertex);
+	}
+
+	// Some functions used for sorting actions by partition number.
 
 	std::function<unsigned int(Actiongraph::Impl::vertex_descriptor)> key_fnc1 =
 	    [&actiongraph, &devicegraph_lhs](Actiongraph::Impl::vertex_descriptor vertex) {
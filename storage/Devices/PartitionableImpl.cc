@@ -146,10 +146,17 @@ namespace storage
     }
 
 
+    bool
+    Partitionable::Impl::is_probe_pass_1c_needed() const
+    {
+	return !has_children() && is_active() && get_size() != 0;
+    }
+
+
     void
     Partitionable::Impl::probe_pass_1c(Prober& prober)
     {
-	if (has_children() || !is_active() || get_size() == 0)
+	if (!is_probe_pass_1c_needed())
 	    return;
 
 	try
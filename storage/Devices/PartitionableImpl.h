@@ -65,6 +65,11 @@ namespace storage
 	virtual void probe_pass_1a(Prober& prober) override;
 	virtual void probe_pass_1c(Prober& prober) override;
 
+	/**
+	 * Returns whether probe_pass_1c() looks for a partition table.
+	 */
+	bool is_probe_pass_1c_needed() const;
+
 	PartitionTable* create_partition_table(PtType pt_type);
 
 	bool has_partition_table() const;
@@ -78,7 +78,7 @@ namespace storage
     StrayBlkDevice*
     StrayBlkDevice::clone() const
     {
-	return new StrayBlkDevice(get_impl().clone());
+	return new StrayBlkDevice(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
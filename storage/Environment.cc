@@ -112,6 +112,34 @@ namespace storage
     }
 
 
+    const string&
+    Environment::get_probe_cache_filename() const
+    {
+	return get_impl().get_probe_cache_filename();
+    }
+
+
+    void
+    Environment::set_probe_cache_filename(const string& probe_cache_filename)
+    {
+	get_impl().set_probe_cache_filename(probe_cache_filename);
+    }
+
+
+    unsigned int
+    Environment::get_max_parallel_probes() const
+    {
+	return get_impl().get_max_parallel_probes();
+    }
+
+
+    void
+    Environment::set_max_parallel_probes(unsigned int max_parallel_probes)
+    {
+	get_impl().set_max_parallel_probes(max_parallel_probes);
+    }
+
+
     std::ostream&
     operator<<(std::ostream& out, const Environment& environment)
     {
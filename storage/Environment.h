@@ -75,6 +75,26 @@ namespace storage
 	const std::string& get_mockup_filename() const;
 	void set_mockup_filename(const std::string& mockup_filename);
 
+	/**
+	 * File used to cache the output of the commands run during probing
+	 * between processes. Only used when probing the system (not when
+	 * reading or writing a mockup). Empty (the default) disables the
+	 * cache.
+	 */
+	const std::string& get_probe_cache_filename() const;
+	void set_probe_cache_filename(const std::string& probe_cache_filename);
+
+	/**
+	 * Maximal number of external programs run at the same time during
+	 * probing. The default is 8. One disables running programs in
+	 * parallel. The programs are started and waited for in the thread
+	 * calling Storage::probe(), so the logger and callbacks are only
+	 * called from that thread. Programs are never run in parallel if
+	 * remote callbacks are set.
+	 */
+	unsigned int get_max_parallel_probes() const;
+	void set_max_parallel_probes(unsigned int max_parallel_probes);
+
 	friend std::ostream& operator<<(std::ostream& out, const Environment& environment);
 
     public:
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <ostream>
+#include <algorithm>
 
 #include "storage/EnvironmentImpl.h"
 
@@ -31,7 +32,8 @@ namespace storage
 {
 
     Environment::Impl::Impl(bool read_only, ProbeMode probe_mode, TargetMode target_mode)
-	: read_only(read_only), probe_mode(probe_mode), target_mode(target_mode)
+	: read_only(read_only), probe_mode(probe_mode), target_mode(target_mode),
+	  max_parallel_probes(8)
     {
     }
 
@@ -62,6 +64,20 @@ namespace storage
     }
 
 
+    void
+    Environment::Impl::set_probe_cache_filename(const string& probe_cache_filename)
+    {
+	Impl::probe_cache_filename = probe_cache_filename;
+    }
+
+
+    void
+    Environment::Impl::set_max_parallel_probes(unsigned int max_parallel_probes)
+    {
+	Impl::max_parallel_probes = std::max(max_parallel_probes, 1U);
+    }
+
+
     bool
     Environment::Impl::is_do_lock() const
     {
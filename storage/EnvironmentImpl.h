@@ -56,6 +56,12 @@ namespace storage
 	const string& get_mockup_filename() const { return mockup_filename; }
 	void set_mockup_filename(const string& mockup_filename);
 
+	const string& get_probe_cache_filename() const { return probe_cache_filename; }
+	void set_probe_cache_filename(const string& probe_cache_filename);
+
+	unsigned int get_max_parallel_probes() const { return max_parallel_probes; }
+	void set_max_parallel_probes(unsigned int max_parallel_probes);
+
 	bool is_debug_credentials() const { return false; }
 
 	bool is_do_lock() const;
@@ -70,6 +76,8 @@ namespace storage
 	string devicegraph_filename;
 	string arch_filename;
 	string mockup_filename;
+	string probe_cache_filename;
+	unsigned int max_parallel_probes;
 
     };
 
@@ -70,7 +70,7 @@ namespace storage
 
 	set_array_line(array_line(entry), entry.uuid);
 
-	mdadm.save();
+	save();
 
 	return true;
     }
@@ -97,12 +97,33 @@ namespace storage
 
 	lines.erase(it);
 
-	mdadm.save();
+	save();
 
 	return true;
     }
 
 
+    void
+    EtcMdadm::write()
+    {
+	if (modified)
+	{
+	    mdadm.save();
+	    modified = false;
+	}
+    }
+
+
+    void
+    EtcMdadm::save()
+    {
+	modified = true;
+
+	if (auto_save)
+	    write();
+    }
+
+
     void
     EtcMdadm::set_device_line(const string& line)
     {
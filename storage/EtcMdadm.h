@@ -72,6 +72,22 @@ namespace storage
 
 	bool remove_entry(const string& uuid);
 
+	/**
+	 * By default the file is saved after every change. With auto save
+	 * disabled the changes are only saved by write().
+	 */
+	void set_auto_save(bool auto_save) { EtcMdadm::auto_save = auto_save; }
+
+	/**
+	 * See AsciiFile::set_replace().
+	 */
+	void set_replace(bool replace) { mdadm.set_replace(replace); }
+
+	/**
+	 * Save the file if it was changed since the last save.
+	 */
+	void write();
+
     protected:
 
 	void set_device_line(const string& line);
@@ -89,6 +105,11 @@ namespace storage
 
 	AsciiFile mdadm;
 
+	bool auto_save = true;
+	bool modified = false;
+
+	void save();
+
     };
 
 }
@@ -222,11 +222,7 @@ namespace storage
     vector<const BlkFilesystem*>
     BlkFilesystem::find_by_uuid(const Devicegraph* devicegraph, const string& uuid)
     {
-	auto pred = [&uuid](const BlkFilesystem* blk_filesystem) {
-	    return blk_filesystem->get_uuid() == uuid;
-	};
-
-	return devicegraph->get_impl().get_devices_of_type_if<const BlkFilesystem>(pred);
+	return devicegraph->get_impl().find_devices_by_uuid<const BlkFilesystem>(uuid);
     }
 
 
@@ -117,7 +117,11 @@ namespace storage
     void
     BlkFilesystem::Impl::set_uuid(const string& uuid)
     {
+	string old_uuid = Impl::uuid;
+
 	Impl::uuid = uuid;
+
+	uuid_index_changed(old_uuid);
     }
 
 
@@ -251,7 +255,7 @@ namespace storage
 	if (it != blkid.end())
 	{
 	    label = it->second.fs_label;
-	    uuid = it->second.fs_uuid;
+	    set_uuid(it->second.fs_uuid);
 	}
     }
 
@@ -307,7 +311,7 @@ namespace storage
 	const Blkid& blkid(blk_device->get_name());
 	Blkid::const_iterator it = blkid.get_sole_entry();
 	if (it != blkid.end())
-	    uuid = it->second.fs_uuid;
+	    set_uuid(it->second.fs_uuid);
     }
 
 
@@ -861,8 +865,7 @@ namespace storage
 	for (FstabEntry* entry : find_etc_fstab_entries(etc_fstab, { mount_point->get_impl().get_fstab_device_name() }))
 	{
 	    entry->set_device(get_mount_by_name(mount_point->get_mount_by()));
-	    etc_fstab.log_diff();
-	    etc_fstab.write();
+	    commit_data.write_etc_fstab();
 	}
     }
 
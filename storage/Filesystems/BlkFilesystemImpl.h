@@ -76,6 +76,8 @@ namespace storage
 	const string& get_uuid() const { return uuid; }
 	void set_uuid(const string& uuid);
 
+	virtual string get_index_uuid() const override { return uuid; }
+
 	virtual bool supports_external_journal() const { return false; }
 
 	const string& get_mkfs_options() const { return mkfs_options; }
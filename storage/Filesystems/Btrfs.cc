@@ -214,7 +214,7 @@ namespace storage
     Btrfs*
     Btrfs::clone() const
     {
-	return new Btrfs(get_impl().clone());
+	return new Btrfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
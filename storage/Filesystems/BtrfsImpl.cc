@@ -592,7 +592,13 @@ namespace storage
     Btrfs::Impl::do_mount(CommitData& commit_data, const CommitOptions& commit_options, MountPoint* mount_point) const
     {
         if (snapper_config)
+        {
+            // the snapper installation helper may need the config files
+
+            commit_data.write_config_files();
+
             snapper_config->pre_mount();
+        }
 
         BlkFilesystem::Impl::do_mount(commit_data, commit_options, mount_point);
 
@@ -607,7 +613,11 @@ namespace storage
         BlkFilesystem::Impl::do_add_to_etc_fstab(commit_data, mount_point);
 
         if (snapper_config)
+        {
+            commit_data.write_config_files();
+
             snapper_config->post_add_to_etc_fstab(commit_data.get_etc_fstab());
+        }
     }
 
 
@@ -141,7 +141,7 @@ namespace storage
     BtrfsSubvolume*
     BtrfsSubvolume::clone() const
     {
-	return new BtrfsSubvolume(get_impl().clone());
+	return new BtrfsSubvolume(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
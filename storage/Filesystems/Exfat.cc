@@ -57,7 +57,7 @@ namespace storage
     Exfat*
     Exfat::clone() const
     {
-	return new Exfat(get_impl().clone());
+	return new Exfat(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     Ext2*
     Ext2::clone() const
     {
-	return new Ext2(get_impl().clone());
+	return new Ext2(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     Ext3*
     Ext3::clone() const
     {
-	return new Ext3(get_impl().clone());
+	return new Ext3(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     Ext4*
     Ext4::clone() const
     {
-	return new Ext4(get_impl().clone());
+	return new Ext4(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     F2fs*
     F2fs::clone() const
     {
-	return new F2fs(get_impl().clone());
+	return new F2fs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
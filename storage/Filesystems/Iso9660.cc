@@ -57,7 +57,7 @@ namespace storage
     Iso9660*
     Iso9660::clone() const
     {
-	return new Iso9660(get_impl().clone());
+	return new Iso9660(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
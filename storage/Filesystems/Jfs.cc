@@ -58,7 +58,7 @@ namespace storage
     Jfs*
     Jfs::clone() const
     {
-	return new Jfs(get_impl().clone());
+	return new Jfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -257,7 +257,7 @@ namespace storage
     MountPoint*
     MountPoint::clone() const
     {
-	return new MountPoint(get_impl().clone());
+	return new MountPoint(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -291,8 +291,7 @@ namespace storage
 	entry->set_dump_pass(mount_point->get_freq());
 
 	etc_fstab.add(entry);
-	etc_fstab.log_diff();
-	etc_fstab.write();
+	commit_data.write_etc_fstab();
     }
 
 
@@ -327,8 +326,7 @@ namespace storage
 	    entry->set_fsck_pass(mount_point->get_passno());
 	    entry->set_dump_pass(mount_point->get_freq());
 
-	    etc_fstab.log_diff();
-	    etc_fstab.write();
+	    commit_data.write_etc_fstab();
 	}
     }
 
@@ -358,8 +356,7 @@ namespace storage
 	for (FstabEntry* entry : find_etc_fstab_entries(etc_fstab, { mount_point->get_impl().get_fstab_device_name() }))
 	{
 	    etc_fstab.remove(entry);
-	    etc_fstab.log_diff();
-	    etc_fstab.write();
+	    commit_data.write_etc_fstab();
 	}
     }
 
@@ -78,7 +78,7 @@ namespace storage
     Nfs*
     Nfs::clone() const
     {
-	return new Nfs(get_impl().clone());
+	return new Nfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -57,7 +57,7 @@ namespace storage
     Ntfs*
     Ntfs::clone() const
     {
-	return new Ntfs(get_impl().clone());
+	return new Ntfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -57,7 +57,7 @@ namespace storage
     Reiserfs*
     Reiserfs::clone() const
     {
-	return new Reiserfs(get_impl().clone());
+	return new Reiserfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
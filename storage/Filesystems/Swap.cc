@@ -58,7 +58,7 @@ namespace storage
     Swap*
     Swap::clone() const
     {
-	return new Swap(get_impl().clone());
+	return new Swap(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -57,7 +57,7 @@ namespace storage
     Udf*
     Udf::clone() const
     {
-	return new Udf(get_impl().clone());
+	return new Udf(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
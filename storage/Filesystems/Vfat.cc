@@ -57,7 +57,7 @@ namespace storage
     Vfat*
     Vfat::clone() const
     {
-	return new Vfat(get_impl().clone());
+	return new Vfat(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
@@ -58,7 +58,7 @@ namespace storage
     Xfs*
     Xfs::clone() const
     {
-	return new Xfs(get_impl().clone());
+	return new Xfs(&dynamic_cast<Impl&>(get_shared_impl()));
     }
 
 
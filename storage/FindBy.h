@@ -39,14 +39,11 @@ namespace storage
     Type*
     find_by_name(Devicegraph* devicegraph, const string& name)
     {
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    Type* device = dynamic_cast<Type*>(devicegraph->get_impl()[vertex]);
-	    if (device && device->get_impl().get_name() == name)
-		return device;
-	}
-
-	ST_THROW(DeviceNotFoundByName(name));
+	Type* device = devicegraph->get_impl().find_device_by_name<Type>(name);
+	if (!device)
+	    ST_THROW(DeviceNotFoundByName(name));
+
+	return device;
     }
 
 
@@ -54,14 +51,11 @@ namespace storage
     const Type*
     find_by_name(const Devicegraph* devicegraph, const string& name)
     {
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    const Type* device = dynamic_cast<const Type*>(devicegraph->get_impl()[vertex]);
-	    if (device && device->get_impl().get_name() == name)
-		return device;
-	}
-
-	ST_THROW(DeviceNotFoundByName(name));
+	const Type* device = devicegraph->get_impl().find_device_by_name<const Type>(name);
+	if (!device)
+	    ST_THROW(DeviceNotFoundByName(name));
+
+	return device;
     }
 
 
@@ -69,14 +63,11 @@ namespace storage
     Type*
     find_by_uuid(Devicegraph* devicegraph, const string& uuid)
     {
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    Type* device = dynamic_cast<Type*>(devicegraph->get_impl()[vertex]);
-	    if (device && device->get_impl().get_uuid() == uuid)
-		return device;
-	}
-
-	ST_THROW(DeviceNotFoundByUuid(uuid));
+	Type* device = devicegraph->get_impl().find_device_by_uuid<Type>(uuid);
+	if (!device)
+	    ST_THROW(DeviceNotFoundByUuid(uuid));
+
+	return device;
     }
 
 
@@ -84,14 +75,11 @@ namespace storage
     const Type*
     find_by_uuid(const Devicegraph* devicegraph, const string& uuid)
     {
-	for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph->get_impl().vertices())
-	{
-	    const Type* device = dynamic_cast<const Type*>(devicegraph->get_impl()[vertex]);
-	    if (device && device->get_impl().get_uuid() == uuid)
-		return device;
-	}
-
-	ST_THROW(DeviceNotFoundByUuid(uuid));
+	const Type* device = devicegraph->get_impl().find_device_by_uuid<const Type>(uuid);
+	if (!device)
+	    ST_THROW(DeviceNotFoundByUuid(uuid));
+
+	return device;
     }
 
 }
@@ -26,6 +26,7 @@
 #include "storage/Prober.h"
 #include "storage/Devices/BlkDeviceImpl.h"
 #include "storage/SystemInfo/SystemInfo.h"
+#include "storage/SystemInfo/CmdUdevadm.h"
 #include "storage/Utils/StorageDefines.h"
 #include "storage/Utils/CallbacksImpl.h"
 #include "storage/StorageImpl.h"
@@ -52,6 +53,49 @@ namespace storage
 {
 
 
+    /**
+     * Runs 'udevadm info' for the entries in /sys/block in parallel. Must
+     * only prefetch what probe_sys_block_entries() queries anyway.
+     */
+    static void
+    prefetch_sys_block_entries(SystemInfo& system_info, const Dir& dir)
+    {
+	// In batch mode all devices are queried at once anyway.
+
+	if (system_info.is_batch_mode() && CmdUdevadmExportDb::is_usable())
+	    return;
+
+	vector<string> udevadm_names;
+
+	for (const string& short_name : dir)
+	{
+	    if (boost::starts_with(short_name, "loop") || boost::starts_with(short_name, "dm-"))
+		continue;
+
+	    string name = DEV_DIR "/" + short_name;
+
+	    try
+	    {
+		if (!system_info.getCmdStat(name).is_blk())
+		    continue;
+	    }
+	    catch (const Exception& exception)
+	    {
+		ST_CAUGHT(exception);
+
+		break;
+	    }
+
+	    if (Md::Impl::is_valid_sysfs_name(name) || Bcache::Impl::is_valid_name(name))
+		continue;
+
+	    udevadm_names.push_back(name);
+	}
+
+	system_info.prefetchCmdUdevadmInfos(udevadm_names);
+    }
+
+
     SysBlockEntries
     probe_sys_block_entries(SystemInfo& system_info)
     {
@@ -59,7 +103,11 @@ namespace storage
 
 	SysBlockEntries sys_block_entries;
 
-	for (const string& short_name : system_info.getDir(SYSFS_DIR "/block"))
+	const Dir& dir = system_info.getDir(SYSFS_DIR "/block");
+
+	prefetch_sys_block_entries(system_info, dir);
+
+	for (const string& short_name : dir)
 	{
 	    if (boost::starts_with(short_name, "loop") || boost::starts_with(short_name, "dm-"))
 		continue;
@@ -193,6 +241,12 @@ namespace storage
 	 * Pass 2:  Probe filesystems and mount points.
 	 */
 
+	// The first query of udev empties the udev queue. Later queries of
+	// udev during probing only settle again if the library caused udev
+	// events in the meantime.
+
+	UdevadmSettle::Epoch udevadm_settle_epoch;
+
 	try
 	{
 	    sys_block_entries = probe_sys_block_entries(system_info);
@@ -362,6 +416,8 @@ namespace storage
 
 	try
 	{
+	    prefetch_partitions();
+
 	    for (Devicegraph::Impl::vertex_descriptor vertex : system->get_impl().vertices())
 	    {
 		Device* device = system->get_impl()[vertex];
@@ -473,10 +529,32 @@ namespace storage
 	    error_callback(probe_callbacks, _("Probing NFS failed"), exception);
 	}
 
+	y2mil("prober statistics udevadm-settles:" << UdevadmSettle::get_count());
+
 	y2mil("prober done");
     }
 
 
+    void
+    Prober::prefetch_partitions()
+    {
+	vector<string> names;
+
+	for (Devicegraph::Impl::vertex_descriptor vertex : system->get_impl().vertices())
+	{
+	    const Device* device = system->get_impl()[vertex];
+	    if (is_partitionable(device))
+	    {
+		const Partitionable* partitionable = to_partitionable(device);
+		if (partitionable->get_impl().is_probe_pass_1c_needed())
+		    names.push_back(partitionable->get_name());
+	    }
+	}
+
+	system_info.prefetchParteds(names);
+    }
+
+
     void
     Prober::add_holder(const string& name, Device* b, add_holder_func_t add_holder_func)
     {
@@ -114,6 +114,11 @@ namespace storage
 
 	vector<pending_holder_t> pending_holders;
 
+	/**
+	 * Runs parted for all partitionables probed in pass 1c in parallel.
+	 */
+	void prefetch_partitions();
+
 	/**
 	 * Flushes the pendings holders. If a BlkDevice is still not found an
 	 * exception is thrown.
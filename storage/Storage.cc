@@ -224,6 +224,13 @@ namespace storage
 	get_impl().probe(probe_callbacks);
     }
 
+
+    void
+    Storage::reprobe(const vector<string>& kernel_names, const ProbeCallbacks* probe_callbacks)
+    {
+	get_impl().reprobe(kernel_names, probe_callbacks);
+    }
+
     void
     Storage::commit(const CommitCallbacks* commit_callbacks)
     {
@@ -333,6 +333,39 @@ namespace storage
 	 */
 	void probe(const ProbeCallbacks* probe_callbacks = nullptr);
 
+	/**
+	 * Probe the system again after devices were added, removed or
+	 * changed and replace the probed, system and staging devicegraphs.
+	 *
+	 * kernel_names must include the kernel names (e.g. "sda1" or
+	 * "dm-3") of all such devices, e.g. as reported by udev. The
+	 * complete system is probed again but only the system wide
+	 * information and the information about these devices, their
+	 * descendants and their ancestors is queried again. For new devices
+	 * the ancestors are only found via the sysfs path, e.g. the disk of
+	 * a new partition.
+	 *
+	 * The devices are matched by their class, a stable identity (e.g.
+	 * the name of a block device, the UUID of a filesystem or the path
+	 * of a mount point) and the devices they are built on. Devices not
+	 * affected keep their sids. The reported devices and their
+	 * descendants get new sids. Devices that changed without being
+	 * reported, e.g. a filesystem that was reformatted, also get new
+	 * sids.
+	 *
+	 * Changes in the staging devicegraph are discarded.
+	 *
+	 * If the system was not probed before or changed since by commit()
+	 * or activate() a full probe is done.
+	 *
+	 * If an error reported via probe_callbacks is not ignored the
+	 * function throws Aborted.
+	 *
+	 * @throw Aborted, Exception
+	 */
+	void reprobe(const std::vector<std::string>& kernel_names,
+		     const ProbeCallbacks* probe_callbacks = nullptr);
+
 	/**
 	 * The actiongraph must be valid.
 	 *
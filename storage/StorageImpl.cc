@@ -21,10 +21,20 @@
  */
 
 
+#include <string.h>
+#include <unordered_map>
+#include <boost/algorithm/string.hpp>
+
 #include "config.h"
 #include "storage/Utils/AppUtil.h"
+#include "storage/Utils/LoggerImpl.h"
 #include "storage/Utils/Mockup.h"
+#include "storage/Utils/ProbeCache.h"
+#include "storage/Utils/StorageDefines.h"
+#include "storage/Utils/StorageTmpl.h"
 #include "storage/StorageImpl.h"
+#include "storage/DevicegraphImpl.h"
+#include "storage/Devices/BlkDeviceImpl.h"
 #include "storage/Devices/DiskImpl.h"
 #include "storage/Devices/DasdImpl.h"
 #include "storage/Devices/MultipathImpl.h"
@@ -32,6 +42,13 @@
 #include "storage/Devices/MdImpl.h"
 #include "storage/Devices/LvmLvImpl.h"
 #include "storage/Devices/LuksImpl.h"
+#include "storage/Devices/LvmVgImpl.h"
+#include "storage/Devices/LvmPvImpl.h"
+#include "storage/Devices/BcacheCset.h"
+#include "storage/Filesystems/BlkFilesystem.h"
+#include "storage/Filesystems/BtrfsSubvolume.h"
+#include "storage/Filesystems/MountPoint.h"
+#include "storage/Filesystems/Nfs.h"
 #include "storage/SystemInfo/SystemInfo.h"
 #include "storage/Actiongraph.h"
 #include "storage/Prober.h"
@@ -60,6 +77,8 @@ namespace storage
     Storage::Impl::~Impl()
     {
 	// TODO: Make sure logger is destroyed after this object
+
+	flush_logger();
     }
 
 
@@ -86,6 +105,9 @@ namespace storage
 
 	y2mil("activate begin");
 
+	system_info.reset();
+	UdevadmSettle::invalidate();
+
 	Multipath::Impl::activate_multipaths(activate_callbacks);
 
 	Md::Impl::activate_mds(activate_callbacks, tmp_dir);
@@ -115,6 +137,9 @@ namespace storage
     {
 	y2mil("deactivate begin");
 
+	system_info.reset();
+	UdevadmSettle::invalidate();
+
 	/**
 	 * All deactivate functions return true if nothing is left to
 	 * deactivate (so either deactivation was successful or there was
@@ -156,6 +181,8 @@ namespace storage
     {
 	y2mil("probe begin");
 
+	system_info.reset();
+
 	if (exist_devicegraph("probed"))
 	    remove_devicegraph("probed");
 
@@ -216,11 +243,294 @@ namespace storage
     void
     Storage::Impl::probe_helper(const ProbeCallbacks* probe_callbacks, Devicegraph* probed)
     {
-	SystemInfo system_info;
+	if (!system_info)
+	{
+	    system_info.reset(new SystemInfo());
+	    system_info->set_max_parallel_probes(environment.get_max_parallel_probes());
+	    system_info->set_batch_mode(true);
+	}
+
+	const string& probe_cache_filename = environment.get_probe_cache_filename();
+
+	bool use_probe_cache = !probe_cache_filename.empty() &&
+	    Mockup::get_mode() == Mockup::Mode::NONE;
+
+	if (use_probe_cache)
+	    ProbeCache::load(probe_cache_filename);
+
+	try
+	{
+	    arch = system_info->getArch();
+
+	    Prober prober(probe_callbacks, probed, *system_info);
+	}
+	catch (...)
+	{
+	    ProbeCache::clear();
+	    throw;
+	}
+
+	if (use_probe_cache)
+	    ProbeCache::save(probe_cache_filename);
+    }
+
+
+    namespace
+    {
+
+	/**
+	 * Returns the property identifying the device on the system, e.g. the
+	 * name of a block device or the UUID of a filesystem. Unlike the
+	 * displayname it does not change when the device is modified. Empty
+	 * for devices identified by their parents only, e.g. partition
+	 * tables.
+	 */
+	string
+	stable_identity(const Device* device)
+	{
+	    if (is_blk_device(device))
+		return to_blk_device(device)->get_name();
+
+	    if (is_blk_filesystem(device))
+		return to_blk_filesystem(device)->get_uuid();
+
+	    if (is_lvm_vg(device))
+		return to_lvm_vg(device)->get_impl().get_uuid();
+
+	    if (is_lvm_pv(device))
+		return to_lvm_pv(device)->get_impl().get_uuid();
+
+	    if (is_bcache_cset(device))
+		return to_bcache_cset(device)->get_uuid();
+
+	    if (is_btrfs_subvolume(device))
+		return to_string(to_btrfs_subvolume(device)->get_id());
+
+	    if (is_mount_point(device))
+		return to_mount_point(device)->get_path();
+
+	    if (is_nfs(device))
+		return to_nfs(device)->get_server() + ":" + to_nfs(device)->get_path();
+
+	    return "";
+	}
+
+
+	/**
+	 * Returns a key identifying the device independent of its sid. The
+	 * key is made of the classname and stable identity of the device
+	 * and the keys of its parents.
+	 */
+	const string&
+	reprobe_key(const Devicegraph::Impl& devicegraph, Devicegraph::Impl::vertex_descriptor vertex,
+		    map<Devicegraph::Impl::vertex_descriptor, string>& keys)
+	{
+	    map<Devicegraph::Impl::vertex_descriptor, string>::const_iterator it = keys.find(vertex);
+	    if (it != keys.end())
+		return it->second;
+
+	    const Device* device = devicegraph[vertex];
+
+	    vector<string> parent_keys;
+	    for (Devicegraph::Impl::vertex_descriptor parent : devicegraph.parents(vertex))
+		parent_keys.push_back(reprobe_key(devicegraph, parent, keys));
+
+	    sort(parent_keys.begin(), parent_keys.end());
+
+	    string key = string(device->get_impl().get_classname()) + ":" + stable_identity(device) +
+		"[" + boost::join(parent_keys, ",") + "]";
+
+	    return keys[vertex] = key;
+	}
+
+
+	map<string, Devicegraph::Impl::vertex_descriptor>
+	unique_reprobe_keys(const Devicegraph::Impl& devicegraph)
+	{
+	    map<Devicegraph::Impl::vertex_descriptor, string> keys;
+
+	    map<string, Devicegraph::Impl::vertex_descriptor> ret;
+	    set<string> ambiguous;
+
+	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph.vertices())
+	    {
+		const string& key = reprobe_key(devicegraph, vertex, keys);
+		if (!ret.emplace(key, vertex).second)
+		    ambiguous.insert(key);
+	    }
+
+	    for (const string& key : ambiguous)
+	    {
+		y2war("ambiguous reprobe key " << key);
+		ret.erase(key);
+	    }
+
+	    return ret;
+	}
+
+
+	/**
+	 * Gives the devices in new_devicegraph the sids of the corresponding
+	 * devices in old_devicegraph unless they are affected.
+	 *
+	 * The parents of an unaffected device are unaffected too, so its key
+	 * only changes if the device itself changed without being reported.
+	 */
+	void
+	keep_sids(const Devicegraph* old_devicegraph, Devicegraph* new_devicegraph,
+		  const set<sid_t>& affected_sids)
+	{
+	    const Devicegraph::Impl& old_impl = old_devicegraph->get_impl();
+	    Devicegraph::Impl& new_impl = new_devicegraph->get_impl();
+
+	    map<string, Devicegraph::Impl::vertex_descriptor> old_keys = unique_reprobe_keys(old_impl);
+	    map<string, Devicegraph::Impl::vertex_descriptor> new_keys = unique_reprobe_keys(new_impl);
+
+	    for (const map<string, Devicegraph::Impl::vertex_descriptor>::value_type& new_key : new_keys)
+	    {
+		map<string, Devicegraph::Impl::vertex_descriptor>::const_iterator it = old_keys.find(new_key.first);
+		if (it == old_keys.end())
+		    continue;
+
+		sid_t sid = old_impl[it->second]->get_sid();
+		if (affected_sids.count(sid) == 0)
+		    new_impl[new_key.second]->get_impl().set_sid(sid);
+	    }
+
+	    for (const map<string, Devicegraph::Impl::vertex_descriptor>::value_type& old_key : old_keys)
+	    {
+		sid_t sid = old_impl[old_key.second]->get_sid();
+		if (affected_sids.count(sid) == 0 && new_keys.count(old_key.first) == 0)
+		    y2war("unaffected device not found again, key:" << old_key.first << " sid:" << sid);
+	    }
+	}
+
+    }
+
+
+    void
+    Storage::Impl::reprobe(const vector<string>& kernel_names, const ProbeCallbacks* probe_callbacks)
+    {
+	if (!system_info || (environment.get_probe_mode() != ProbeMode::STANDARD &&
+			     environment.get_probe_mode() != ProbeMode::READ_MOCKUP))
+	{
+	    probe(probe_callbacks);
+	    return;
+	}
+
+	y2mil("reprobe begin " << kernel_names);
+
+	// Find the affected devices: the named block devices and their
+	// descendants. The information about the ancestors is also queried
+	// again, e.g. the partition table of the disk when a partition was
+	// added, but the ancestors keep their sids.
+
+	const Devicegraph* probed = get_probed();
+
+	if (!equal_devicegraph("probed", "staging"))
+	    y2war("reprobe discards the changes in staging");
+
+	map<string, const BlkDevice*> blk_devices;
+	for (const BlkDevice* blk_device : BlkDevice::get_all(probed))
+	{
+	    blk_devices[blk_device->get_sysfs_name()] = blk_device;
+	    blk_devices[blk_device->get_name()] = blk_device;
+	}
+
+	set<sid_t> affected_sids;
+	set<string> affected_names;
+
+	auto add_affected_name = [&affected_names](const Device* device) {
+	    if (is_blk_device(device))
+	    {
+		const BlkDevice* blk_device = to_blk_device(device);
+		affected_names.insert(blk_device->get_name());
+		affected_names.insert(DEV_DIR "/" + blk_device->get_sysfs_name());
+	    }
+	};
+
+	vector<string> new_kernel_names;
+
+	for (const string& kernel_name : kernel_names)
+	{
+	    affected_names.insert(DEV_DIR "/" + kernel_name);
+
+	    map<string, const BlkDevice*>::const_iterator it = blk_devices.find(kernel_name);
+	    if (it == blk_devices.end())
+		it = blk_devices.find(DEV_DIR "/" + kernel_name);
+	    if (it == blk_devices.end())
+	    {
+		new_kernel_names.push_back(kernel_name);
+		continue;
+	    }
+
+	    for (const Device* device : it->second->get_descendants(true))
+	    {
+		affected_sids.insert(device->get_sid());
+		add_affected_name(device);
+	    }
+
+	    for (const Device* device : it->second->get_ancestors(false))
+		add_affected_name(device);
+	}
+
+	// For new devices, e.g. a new partition, the ancestors are found via
+	// the sysfs path. Ancestors only known by holders, e.g. of a new MD
+	// RAID, are not found.
+
+	for (const string& kernel_name : new_kernel_names)
+	{
+	    try
+	    {
+		const string& path = system_info->getCmdUdevadmInfo(DEV_DIR "/" + kernel_name).get_path();
+
+		for (const BlkDevice* blk_device : BlkDevice::get_all(probed))
+		{
+		    if (boost::starts_with(path, blk_device->get_sysfs_path() + "/"))
+		    {
+			for (const Device* device : blk_device->get_ancestors(true))
+			    add_affected_name(device);
+		    }
+		}
+	    }
+	    catch (const Exception& exception)
+	    {
+		ST_CAUGHT(exception);
+	    }
+	}
 
-	arch = system_info.getArch();
+	system_info->invalidate(affected_names);
 
-	Prober prober(probe_callbacks, probed, system_info);
+	y2mil("affected sids " << affected_sids);
+
+	// Keep the old probed devicegraph for comparing the sids.
+
+	Devicegraph old_probed(&storage);
+	probed->copy(old_probed);
+
+	remove_devicegraph("probed");
+	remove_devicegraph("staging");
+	remove_devicegraph("system");
+
+	Devicegraph* system = create_devicegraph("system");
+
+	// The mockup was already loaded by probe().
+
+	if (environment.get_probe_mode() == ProbeMode::READ_MOCKUP)
+	    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+
+	probe_helper(probe_callbacks, system);
+
+	keep_sids(&old_probed, system, affected_sids);
+
+	y2mil("reprobe end");
+
+	y2mil("probed devicegraph begin");
+	y2mil(*system);
+	y2mil("probed devicegraph end");
+
+	copy_devicegraph("system", "staging");
+	copy_devicegraph("system", "probed");
     }
 
 
@@ -346,7 +656,12 @@ namespace storage
 	if (it2 == devicegraphs.end())
 	    ST_THROW(Exception(sformat("devicegraph '%s' not found", name)));
 
-	it1->second.get_impl().swap(it2->second.get_impl());
+	// Swapping the implementations avoids copying all devices and
+	// holders. Only the back references must be adjusted afterwards.
+
+	Devicegraph::Impl::swap(it1->second, it2->second);
+	it2->second.get_impl().set_back_references(&it2->second);
+
 	devicegraphs.erase(it1);
     }
 
@@ -370,10 +685,8 @@ namespace storage
     {
 	// check all devicegraphs
 
-	// check that all objects with the same sid have the same type in all
-	// devicegraphs
-
-	map<sid_t, set<string>> all_sids_with_types;
+	vector<unsigned long> generations;
+	generations.reserve(devicegraphs.size());
 
 	for (const map<string, Devicegraph>::value_type& key_value : devicegraphs)
 	{
@@ -381,24 +694,40 @@ namespace storage
 
 	    devicegraph.check(check_callbacks);
 
-	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph.get_impl().vertices())
-	    {
-		const Device* device = devicegraph.get_impl()[vertex];
-		all_sids_with_types[device->get_sid()].insert(device->get_impl().get_classname());
-	    }
+	    generations.push_back(devicegraph.get_impl().get_generation());
 	}
 
-	for (const map<sid_t, set<string>>::value_type& key_value : all_sids_with_types)
+	// the generations are unique so if they did not change no devicegraph
+	// was modified, added or removed
+
+	if (generations == checked_generations)
+	    return;
+
+	// check that all objects with the same sid have the same type in all
+	// devicegraphs, if any devicegraph changed all devicegraphs are
+	// compared again
+
+	std::unordered_map<sid_t, const char*> classnames;
+
+	for (const map<string, Devicegraph>::value_type& key_value : devicegraphs)
 	{
-	    if (key_value.second.size() != 1)
+	    const Devicegraph& devicegraph = key_value.second;
+
+	    for (Devicegraph::Impl::vertex_descriptor vertex : devicegraph.get_impl().vertices())
 	    {
-		stringstream tmp;
-		tmp << key_value.second;
+		const Device* device = devicegraph.get_impl()[vertex];
+		const char* classname = device->get_impl().get_classname();
+
+		std::pair<std::unordered_map<sid_t, const char*>::iterator, bool> tmp =
+		    classnames.emplace(device->get_sid(), classname);
 
-		ST_THROW(Exception(sformat("objects with sid %d have different types %s",
-					   key_value.first, tmp.str())));
+		if (!tmp.second && strcmp(tmp.first->second, classname) != 0)
+		    ST_THROW(Exception(sformat("objects with sid %d have different types %s and %s",
+					       device->get_sid(), tmp.first->second, classname)));
 	    }
 	}
+
+	checked_generations = generations;
     }
 
 
@@ -434,6 +763,9 @@ namespace storage
     {
 	ST_CHECK_PTR(actiongraph.get());
 
+	system_info.reset();
+	UdevadmSettle::invalidate();
+
 	actiongraph->get_impl().commit(commit_options, commit_callbacks);
 
 	// TODO somehow update probed
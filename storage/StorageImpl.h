@@ -41,6 +41,9 @@ namespace storage
     using std::map;
 
 
+    class SystemInfo;
+
+
     class Storage::Impl
     {
     public:
@@ -93,6 +96,7 @@ namespace storage
 	DeactivateStatus deactivate() const;
 
 	void probe(const ProbeCallbacks* probe_callbacks);
+	void reprobe(const vector<string>& kernel_names, const ProbeCallbacks* probe_callbacks);
 
 	void commit(const CommitOptions& commit_options, const CommitCallbacks* commit_callbacks);
 
@@ -118,6 +122,19 @@ namespace storage
 
 	std::unique_ptr<const Actiongraph> actiongraph;
 
+	/**
+	 * The generations of all devicegraphs at the last successful
+	 * check. Used to skip the checks across devicegraphs if no
+	 * devicegraph changed.
+	 */
+	mutable vector<unsigned long> checked_generations;
+
+	/**
+	 * The system information from the last probe, reused by
+	 * reprobe(). Dropped whenever the system is modified.
+	 */
+	mutable std::unique_ptr<SystemInfo> system_info;
+
 	TmpDir tmp_dir;
 
     };
@@ -40,7 +40,10 @@ namespace storage
 
     Blkid::Blkid()
     {
-	SystemCmd cmd(BLKIDBIN " -c '/dev/null'");
+	SystemCmd::Options cmd_options(BLKIDBIN " -c '/dev/null'");
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
 	if (cmd.retcode() == 0)
 	    parse(cmd.stdout());
     }
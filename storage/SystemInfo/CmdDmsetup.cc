@@ -38,8 +38,11 @@ namespace storage
 
     CmdDmsetupInfo::CmdDmsetupInfo()
     {
-	SystemCmd cmd(DMSETUPBIN " --columns --separator '/' --noheadings -o name,major,minor,"
-		      "segments,subsystem,uuid info");
+	SystemCmd::Options cmd_options(DMSETUPBIN " --columns --separator '/' --noheadings -o name,major,minor,"
+				       "segments,subsystem,uuid info");
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
 	if (cmd.retcode() == 0 && !cmd.stdout().empty())
 	    parse(cmd.stdout());
     }
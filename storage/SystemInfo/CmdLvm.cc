@@ -65,8 +65,11 @@ namespace storage
 
     CmdPvs::CmdPvs()
     {
-	SystemCmd cmd(PVSBIN " " COMMON_LVM_OPTIONS " --all --options pv_name,pv_uuid,"
-		      "vg_name,vg_uuid,pv_attr,pe_start");
+	SystemCmd::Options cmd_options(PVSBIN " " COMMON_LVM_OPTIONS " --all --options pv_name,pv_uuid,"
+				       "vg_name,vg_uuid,pv_attr,pe_start");
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
 	if (cmd.retcode() == 0 && !cmd.stdout().empty())
 	    parse(cmd.stdout());
     }
@@ -154,9 +157,12 @@ namespace storage
 
     CmdLvs::CmdLvs()
     {
-	SystemCmd cmd(LVSBIN " " COMMON_LVM_OPTIONS " --all --options lv_name,lv_uuid,vg_name,"
-		      "vg_uuid,lv_role,lv_attr,lv_size,stripes,stripe_size,chunk_size,pool_lv,"
-		      "pool_lv_uuid,data_lv,data_lv_uuid,metadata_lv,metadata_lv_uuid");
+	SystemCmd::Options cmd_options(LVSBIN " " COMMON_LVM_OPTIONS " --all --options lv_name,lv_uuid,vg_name,"
+				       "vg_uuid,lv_role,lv_attr,lv_size,stripes,stripe_size,chunk_size,pool_lv,"
+				       "pool_lv_uuid,data_lv,data_lv_uuid,metadata_lv,metadata_lv_uuid");
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
 
 	if (cmd.retcode() == 0 && !cmd.stdout().empty())
 	    parse(cmd.stdout());
@@ -331,8 +337,11 @@ namespace storage
 
     CmdVgs::CmdVgs()
     {
-	SystemCmd cmd(VGSBIN " " COMMON_LVM_OPTIONS " --options vg_name,vg_uuid,vg_attr,"
-		      "vg_extent_size,vg_extent_count,vg_free_count");
+	SystemCmd::Options cmd_options(VGSBIN " " COMMON_LVM_OPTIONS " --options vg_name,vg_uuid,vg_attr,"
+				       "vg_extent_size,vg_extent_count,vg_free_count");
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
 	if (cmd.retcode() == 0 && !cmd.stdout().empty())
 	    parse(cmd.stdout());
     }
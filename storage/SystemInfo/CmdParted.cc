@@ -28,6 +28,7 @@
 #include "storage/Utils/SystemCmd.h"
 #include "storage/Utils/StorageDefines.h"
 #include "storage/SystemInfo/CmdParted.h"
+#include "storage/SystemInfo/CmdUdevadm.h"
 #include "storage/Utils/Enum.h"
 #include "storage/Devices/PartitionImpl.h"
 #include "storage/Utils/StorageTypes.h"
@@ -41,16 +42,21 @@ namespace storage
 
 
     Parted::Parted(const string& device)
+	: Parted(device, SystemCmd(options(device)))
+    {
+    }
+
+
+    Parted::Parted(const string& device, const SystemCmd& cmd)
 	: device(device), label(PtType::UNKNOWN), region(), implicit(false),
 	  gpt_undersized(false), gpt_backup_broken(false), gpt_pmbr_boot(false),
 	  logical_sector_size(0), physical_sector_size(0)
     {
-	SystemCmd::Options options(PARTEDBIN " --script --machine " + quote(device) +
-				   " unit s print");
-	options.throw_behaviour = SystemCmd::DoThrow;
-	options.verify = [](int) { return true; };
-
-	SystemCmd cmd(options);
+	// parted opens the device read-write even when all parted commands
+	// are read-only, thus triggering udev events. Not so if the output
+	// was taken from the probe cache.
+	if (!cmd.is_from_probe_cache())
+	    UdevadmSettle::invalidate();
 
 	// No check for exit status since parted 3.1 exits with 1 if no
 	// partition table is found.
@@ -81,6 +87,19 @@ namespace storage
     }
 
 
+    SystemCmd::Options
+    Parted::options(const string& device)
+    {
+	SystemCmd::Options options(PARTEDBIN " --script --machine " + quote(device) +
+				   " unit s print");
+	options.throw_behaviour = SystemCmd::DoThrow;
+	options.verify = [](int) { return true; };
+	options.causes_uevents = true;
+
+	return options;
+    }
+
+
     void
     Parted::parse(const vector<string>& stdout, const vector<string>& stderr)
     {
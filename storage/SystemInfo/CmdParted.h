@@ -26,6 +26,7 @@
 
 
 #include "storage/Utils/Region.h"
+#include "storage/Utils/SystemCmd.h"
 #include "storage/Devices/PartitionTable.h"
 
 
@@ -50,6 +51,18 @@ namespace storage
 	 */
 	Parted(const string& device);
 
+	/**
+	 * Constructor: Take the output of the finished cmd started with the
+	 * options from options(device).
+	 * This may throw a SystemCmdException or a ParseException.
+	 */
+	Parted(const string& device, const SystemCmd& cmd);
+
+	/**
+	 * Options of the 'parted' command for device.
+	 */
+	static SystemCmd::Options options(const string& device);
+
         /**
 	 * Entry for one partition.
 	 */
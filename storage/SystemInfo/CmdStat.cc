@@ -27,6 +27,7 @@
 #include "storage/Utils/SystemCmd.h"
 #include "storage/Utils/Mockup.h"
 #include "storage/Utils/StorageDefines.h"
+#include "storage/Utils/Format.h"
 #include "storage/SystemInfo/CmdStat.h"
 
 
@@ -38,10 +39,35 @@ namespace storage
     CmdStat::CmdStat(const string& path)
 	: path(path), mode(0)
     {
-	SystemCmd cmd(STATBIN " --format '%f' " + quote(path));
+	const string command = STATBIN " --format '%f' " + quote(path);
 
-	if (cmd.retcode() == 0 && cmd.stdout().size() >= 1)
-	    parse(cmd.stdout());
+	// Use stat(2) directly unless the result is needed from the mockup
+	// or a remote system. When recording the result is saved as if the
+	// stat program was run.
+
+	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK || get_remote_callbacks())
+	{
+	    SystemCmd cmd(command);
+
+	    if (cmd.retcode() == 0 && cmd.stdout().size() >= 1)
+		parse(cmd.stdout());
+	}
+	else
+	{
+	    struct stat buf;
+
+	    bool ok = stat(path.c_str(), &buf) == 0;
+	    if (ok)
+		mode = buf.st_mode;
+
+	    if (Mockup::get_mode() == Mockup::Mode::RECORD)
+	    {
+		if (ok)
+		    Mockup::set_command(command, Mockup::Command(vector<string>({ sformat("%x", mode) })));
+		else
+		    Mockup::set_command(command, Mockup::Command({}, { "stat: cannot stat " + quote(path) }, 1));
+	    }
+	}
 
 	y2mil(*this);
     }
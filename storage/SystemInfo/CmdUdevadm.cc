@@ -28,6 +28,8 @@
 #include "storage/Utils/SystemCmd.h"
 #include "storage/Utils/StorageDefines.h"
 #include "storage/Utils/StorageTmpl.h"
+#include "storage/Utils/Mockup.h"
+#include "storage/Utils/LibraryLock.h"
 #include "storage/SystemInfo/CmdUdevadm.h"
 
 
@@ -41,23 +43,46 @@ namespace storage
     });
 
 
-    CmdUdevadmInfo::CmdUdevadmInfo(const string& file)
+#define UDEVADMBIN_EXPORT_DB UDEVADMBIN " info --export-db"
+
+
+    CmdUdevadmInfo::CmdUdevadmInfo(const key_t& file, const CmdUdevadmExportDb* export_db)
 	: file(file), path(), name(), majorminor(0), device_type(DeviceType::UNKNOWN),
 	  by_path_links(), by_id_links()
     {
-	// Without emptying the udev queue 'udevadm info' can display old data
-	// or even complain about unknown devices. Even during probing this
-	// can happen since e.g. 'parted' opens the disk device read-write
-	// even when all parted commands are read-only, thus triggering udev
-	// events. So always run 'udevadm settle'.
-	SystemCmd(UDEVADMBIN_SETTLE);
+	if (export_db)
+	{
+	    const vector<string>* lines = export_db->find(file);
+	    if (lines)
+	    {
+		parse(*lines);
+		return;
+	    }
+	}
 
-	SystemCmd cmd(UDEVADMBIN " info " + quote(file), SystemCmd::DoThrow);
+	UdevadmSettle::settle();
+
+	SystemCmd cmd(options(file));
 
 	parse(cmd.stdout());
     }
 
 
+    CmdUdevadmInfo::CmdUdevadmInfo(const key_t& file, const SystemCmd& cmd)
+	: file(file), path(), name(), majorminor(0), device_type(DeviceType::UNKNOWN),
+	  by_path_links(), by_id_links()
+    {
+	parse(cmd.stdout());
+    }
+
+
+    SystemCmd::Options
+    CmdUdevadmInfo::options(const key_t& file)
+    {
+	return SystemCmd::Options(UDEVADMBIN " info " + quote(file), SystemCmd::DoThrow);
+    }
+
+
     void
     CmdUdevadmInfo::parse(const vector<string>& stdout)
     {
@@ -103,6 +128,101 @@ namespace storage
     }
 
 
+    CmdUdevadmExportDb::CmdUdevadmExportDb()
+    {
+	UdevadmSettle::settle();
+
+	SystemCmd::Options cmd_options(UDEVADMBIN_EXPORT_DB, SystemCmd::DoThrow);
+	cmd_options.log_lines = false;
+
+	SystemCmd cmd(cmd_options);
+
+	parse(cmd.stdout());
+
+	// Only keep the entries of block devices in the mockup, the complete
+	// database is huge.
+
+	if (Mockup::get_mode() == Mockup::Mode::RECORD)
+	{
+	    vector<string> lines;
+
+	    for (const vector<string>& entry : entries)
+	    {
+		lines.insert(lines.end(), entry.begin(), entry.end());
+		lines.push_back("");
+	    }
+
+	    Mockup::set_command(UDEVADMBIN_EXPORT_DB, Mockup::Command(lines, {}, 0));
+	}
+    }
+
+
+    bool
+    CmdUdevadmExportDb::is_usable()
+    {
+	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
+	    return Mockup::has_command(UDEVADMBIN_EXPORT_DB);
+
+	return true;
+    }
+
+
+    void
+    CmdUdevadmExportDb::parse(const vector<string>& stdout)
+    {
+	vector<string> entry;
+
+	auto flush = [this, &entry]() {
+
+	    if (std::find(entry.begin(), entry.end(), "E: SUBSYSTEM=block") != entry.end())
+	    {
+		for (const string& line : entry)
+		{
+		    if (boost::starts_with(line, "N: ") || boost::starts_with(line, "S: "))
+			files[DEV_DIR "/" + line.substr(3)] = entries.size();
+		}
+
+		entries.push_back(entry);
+	    }
+
+	    entry.clear();
+	};
+
+	for (const string& line : stdout)
+	{
+	    if (line.empty())
+		flush();
+	    else
+		entry.push_back(line);
+	}
+
+	flush();
+
+	y2mil(*this);
+    }
+
+
+    const vector<string>*
+    CmdUdevadmExportDb::find(const string& file) const
+    {
+	map<string, size_t>::const_iterator it = files.find(file);
+	if (it == files.end())
+	    return nullptr;
+
+	return &entries[it->second];
+    }
+
+
+    std::ostream&
+    operator<<(std::ostream& s, const CmdUdevadmExportDb& cmd_udevadm_export_db)
+    {
+	s << "entries:" << cmd_udevadm_export_db.entries.size() << " files:"
+	  << cmd_udevadm_export_db.files.size() << '\n';
+
+	return s;
+    }
+
+
     std::ostream&
     operator<<(std::ostream& s, const CmdUdevadmInfo& cmdudevadminfo)
     {
@@ -122,4 +242,77 @@ namespace storage
 	return s;
     }
 
+
+    bool UdevadmSettle::in_epoch = false;
+
+    bool UdevadmSettle::settled = false;
+
+    unsigned int UdevadmSettle::count = 0;
+
+    bool UdevadmSettle::settling = false;
+
+    std::condition_variable UdevadmSettle::settling_done;
+
+
+    void
+    UdevadmSettle::settle()
+    {
+	if (in_epoch)
+	{
+	    while (settling)
+		LibraryLock::wait(settling_done);
+
+	    if (settled)
+		return;
+	}
+
+	settling = true;
+
+	try
+	{
+	    SystemCmd(UDEVADMBIN_SETTLE);
+	}
+	catch (...)
+	{
+	    settling = false;
+	    settling_done.notify_all();
+	    throw;
+	}
+
+	settling = false;
+	settling_done.notify_all();
+
+	settled = true;
+	++count;
+    }
+
+
+    void
+    UdevadmSettle::invalidate()
+    {
+	settled = false;
+    }
+
+
+    void
+    UdevadmSettle::reset()
+    {
+	settled = false;
+	count = 0;
+    }
+
+
+    UdevadmSettle::Epoch::Epoch()
+    {
+	reset();
+	in_epoch = true;
+    }
+
+
+    UdevadmSettle::Epoch::~Epoch()
+    {
+	in_epoch = false;
+	settled = false;
+    }
+
 }
@@ -29,14 +29,21 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <condition_variable>
 
 #include "storage/Utils/Enum.h"
+#include "storage/Utils/SystemCmd.h"
 
 
 namespace storage
 {
     using std::string;
     using std::vector;
+    using std::map;
+
+
+    class CmdUdevadmExportDb;
 
 
     class CmdUdevadmInfo
@@ -46,7 +53,25 @@ namespace storage
 
 	enum class DeviceType { UNKNOWN, DISK, PARTITION };
 
-	CmdUdevadmInfo(const string& file);
+	typedef string key_t;
+
+	/**
+	 * Queries udev for file. If export_db is given and includes file the
+	 * information is taken from it instead of running 'udevadm info'.
+	 */
+	CmdUdevadmInfo(const key_t& file, const CmdUdevadmExportDb* export_db = nullptr);
+
+	/**
+	 * Takes the information from the finished cmd started with the
+	 * options from options(file).
+	 */
+	CmdUdevadmInfo(const key_t& file, const SystemCmd& cmd);
+
+	/**
+	 * Options of the 'udevadm info' command for file. 'udevadm
+	 * settle' must be run before starting the command.
+	 */
+	static SystemCmd::Options options(const key_t& file);
 
 	const string& get_path() const { return path; }
 	const string& get_name() const { return name; }
@@ -80,6 +105,112 @@ namespace storage
 
     };
 
+
+
+    /**
+     * Runs 'udevadm info --export-db' once and keeps the entries of all
+     * block devices. Avoids running 'udevadm info' for every device during
+     * probing.
+     */
+    class CmdUdevadmExportDb
+    {
+
+    public:
+
+	CmdUdevadmExportDb();
+
+	/**
+	 * Returns the lines of the entry for file, either the device name or
+	 * a link, e.g. /dev/sda or /dev/disk/by-id/wwn-0x5000cca, or nullptr
+	 * if no entry is found.
+	 */
+	const vector<string>* find(const string& file) const;
+
+	/**
+	 * Checks whether 'udevadm info --export-db' can be used. In mockup
+	 * playback mode that depends on the mockup including the command.
+	 */
+	static bool is_usable();
+
+	friend std::ostream& operator<<(std::ostream& s, const CmdUdevadmExportDb& cmd_udevadm_export_db);
+
+    private:
+
+	void parse(const vector<string>& stdout);
+
+	vector<vector<string>> entries;
+
+	map<string, size_t> files;
+
+    };
+
+
+    /**
+     * Without emptying the udev queue 'udevadm info' can display old data
+     * or even complain about unknown devices. Running 'udevadm settle'
+     * before every query is slow, so during probing it is only run if it
+     * was not run before or if the library caused udev events since then,
+     * e.g. by activating devices or by running parted. Outside of probing
+     * events from outside the library may arrive at any time, so it is
+     * always run.
+     */
+    class UdevadmSettle
+    {
+
+    public:
+
+	/**
+	 * Scope in which settle() runs 'udevadm settle' only if required,
+	 * used for probing. Creating an Epoch resets the counter.
+	 */
+	class Epoch
+	{
+	public:
+
+	    Epoch();
+	    ~Epoch();
+
+	};
+
+	/**
+	 * Runs 'udevadm settle' if required.
+	 */
+	static void settle();
+
+	/**
+	 * Notes that the library caused udev events so that the next call of
+	 * settle() runs 'udevadm settle'.
+	 */
+	static void invalidate();
+
+	/**
+	 * Like invalidate() and additionally resets the counter.
+	 */
+	static void reset();
+
+	/**
+	 * Returns how often 'udevadm settle' was run by settle() since the
+	 * last reset().
+	 */
+	static unsigned int get_count() { return count; }
+
+    private:
+
+	static bool in_epoch;
+	static bool settled;
+	static unsigned int count;
+
+	/**
+	 * Set while 'udevadm settle' is run by settle(). Since the library
+	 * lock is released during the command, other threads wait for
+	 * settling_done instead of running it again.
+	 */
+	static bool settling;
+	static std::condition_variable settling_done;
+
+    };
+
+
     template <> struct EnumTraits<CmdUdevadmInfo::DeviceType> { static const vector<string> names; };
 
 }
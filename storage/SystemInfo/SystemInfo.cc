@@ -22,6 +22,9 @@
 
 #include "storage/Utils/StorageDefines.h"
 #include "storage/Utils/SystemCmd.h"
+#include "storage/Utils/SystemCmdGroup.h"
+#include "storage/Utils/StorageTmpl.h"
+#include "storage/Utils/Remote.h"
 #include "storage/SystemInfo/SystemInfo.h"
 
 
@@ -29,6 +32,7 @@ namespace storage
 {
 
     SystemInfo::SystemInfo()
+	: max_parallel_probes(1), batch_mode(false)
     {
 	y2deb("constructed SystemInfo");
     }
@@ -39,4 +43,165 @@ namespace storage
 	y2deb("destructed SystemInfo");
     }
 
+
+    const CmdUdevadmInfo&
+    SystemInfo::getCmdUdevadmInfo(const string& file)
+    {
+	const CmdUdevadmExportDb* export_db = nullptr;
+
+	if (batch_mode && CmdUdevadmExportDb::is_usable())
+	{
+	    try
+	    {
+		export_db = &cmd_udevadm_export_db.get();
+	    }
+	    catch (const Exception& exception)
+	    {
+		// fallback to running 'udevadm info' for every device
+		ST_CAUGHT(exception);
+	    }
+	}
+
+	return cmdudevadminfos.get(file, export_db);
+    }
+
+
+    void
+    SystemInfo::invalidate(const set<string>& names)
+    {
+	y2mil("invalidate " << names);
+
+	etc_fstab.reset();
+	etc_crypttab.reset();
+	etc_mdadm.reset();
+
+	dirs.clear();
+	files.clear();
+	mdlinks.reset();
+	procmounts.reset();
+	procmdstat.reset();
+	mdadmexamines.clear();
+	blkid.reset();
+	lsscsi.reset();
+	cmd_dmsetup_info.reset();
+	cmd_dmsetup_table.reset();
+	cmd_cryptsetups.clear();
+	cmddmraid.reset();
+	cmdmultipath.reset();
+
+	cmdbtrfsfilesystemshow.reset();
+	cmdbtrfssubvolumelists.clear();
+	cmdbtrfssubvolumegetdefaults.clear();
+	cmd_btrfs_filesystem_df.clear();
+
+	cmdpvs.reset();
+	cmdvgs.reset();
+	cmdlvs.reset();
+
+	cmd_udevadm_export_db.reset();
+	cmddfs.clear();
+	cmdlsattr.clear();
+
+	// Keep the per device information of unchanged devices.
+
+	auto changed = [&names](const string& name) {
+	    return names.find(name) != names.end();
+	};
+
+	cmd_stats.erase_if([&changed](const string& path, const CmdStat&) {
+	    return changed(path);
+	});
+
+	mdadmdetails.erase_if([&changed](const string& device, const MdadmDetail&) {
+	    return changed(device);
+	});
+
+	parteds.erase_if([&changed](const string& device, const Parted&) {
+	    return changed(device);
+	});
+
+	dasdviews.erase_if([&changed](const string& device, const Dasdview&) {
+	    return changed(device);
+	});
+
+	// The file can also be a link, e.g. /dev/disk/by-id/wwn-0x5000cca.
+
+	cmdudevadminfos.erase_if([&changed](const string& file, const CmdUdevadmInfo& cmd_udevadm_info) {
+	    return changed(file) || changed(DEV_DIR "/" + cmd_udevadm_info.get_name());
+	});
+    }
+
+
+    bool
+    SystemInfo::is_prefetch_enabled(size_t num_args) const
+    {
+	// With remote callbacks the commands are run one after the other
+	// anyway.
+
+	return max_parallel_probes > 1 && num_args > 1 && !get_remote_callbacks();
+    }
+
+
+    template <class Objects>
+    void
+    SystemInfo::prefetch(Objects& objects, const vector<string>& args,
+			 SystemCmd::Options (*options)(const string& arg))
+    {
+	y2mil("prefetch begin " << args.size());
+
+	SystemCmdGroup group;
+
+	for (const string& arg : args)
+	{
+	    if (objects.includes(arg))
+		continue;
+
+	    group.wait(max_parallel_probes - 1);
+
+	    SystemCmd::Options cmd_options = options(arg);
+	    std::function<bool(int)> verify = cmd_options.verify;
+	    cmd_options.throw_behaviour = SystemCmd::NoThrow;
+
+	    try
+	    {
+		group.start(cmd_options, [&objects, arg, verify](const SystemCmd& cmd) {
+		    // Failed commands are run again by the getter which then
+		    // reports the error.
+		    if (verify(cmd.retcode()))
+			objects.emplace(arg, arg, cmd);
+		});
+	    }
+	    catch (const Exception& exception)
+	    {
+		ST_CAUGHT(exception);
+	    }
+	}
+
+	group.wait();
+
+	y2mil("prefetch end");
+    }
+
+
+    void
+    SystemInfo::prefetchCmdUdevadmInfos(const vector<string>& files)
+    {
+	if (!is_prefetch_enabled(files.size()))
+	    return;
+
+	UdevadmSettle::settle();
+
+	prefetch(cmdudevadminfos, files, &CmdUdevadmInfo::options);
+    }
+
+
+    void
+    SystemInfo::prefetchParteds(const vector<string>& devices)
+    {
+	if (!is_prefetch_enabled(devices.size()))
+	    return;
+
+	prefetch(parteds, devices, &Parted::options);
+    }
+
 }
@@ -25,6 +25,7 @@
 #define STORAGE_SYSTEM_INFO_H
 
 
+#include <set>
 #include <boost/noncopyable.hpp>
 
 #include "storage/EtcFstab.h"
@@ -54,6 +55,7 @@
 namespace storage
 {
     using std::map;
+    using std::set;
 
     /**
      * Encapsulates system access, also for testsuite mocking
@@ -77,6 +79,42 @@ namespace storage
 	SystemInfo();
 	~SystemInfo();
 
+	unsigned int get_max_parallel_probes() const { return max_parallel_probes; }
+	void set_max_parallel_probes(unsigned int max_parallel_probes)
+	    { SystemInfo::max_parallel_probes = max_parallel_probes; }
+
+	/**
+	 * Runs 'udevadm info' for all files, up to max_parallel_probes
+	 * commands at the same time, to fill the cache ahead of
+	 * getCmdUdevadmInfo(). The commands are started and waited for in
+	 * the calling thread. Failed commands are not cached, so they are
+	 * run again and the error is reported by the later getter. Does
+	 * nothing if max_parallel_probes is one or remote callbacks are set.
+	 */
+	void prefetchCmdUdevadmInfos(const vector<string>& files);
+
+	/**
+	 * Like prefetchCmdUdevadmInfos() but runs 'parted' for devices to
+	 * fill the cache ahead of getParted().
+	 */
+	void prefetchParteds(const vector<string>& devices);
+
+	/**
+	 * Drops cached information so that it is queried again. Only the
+	 * per device information of devices not included in names (full
+	 * names, e.g. /dev/sda) is kept. Used when probing again after
+	 * devices changed.
+	 */
+	void invalidate(const set<string>& names);
+
+	/**
+	 * In batch mode information is queried for all devices at once
+	 * where possible, e.g. with 'udevadm info --export-db'. Only useful
+	 * if most devices are queried, e.g. during probing.
+	 */
+	bool is_batch_mode() const { return batch_mode; }
+	void set_batch_mode(bool batch_mode) { SystemInfo::batch_mode = batch_mode; }
+
 	const EtcFstab& getEtcFstab() { return etc_fstab.get(); }
 	const EtcCrypttab& getEtcCrypttab() { return etc_crypttab.get(); }
 	const EtcMdadm& getEtcMdadm() { return etc_mdadm.get(); }
@@ -117,7 +155,7 @@ namespace storage
 	const CmdPvs& getCmdPvs() { return cmdpvs.get(); }
 	const CmdVgs& getCmdVgs() { return cmdvgs.get(); }
 	const CmdLvs& getCmdLvs() { return cmdlvs.get(); }
-	const CmdUdevadmInfo& getCmdUdevadmInfo(const string& file) { return cmdudevadminfos.get(file); }
+	const CmdUdevadmInfo& getCmdUdevadmInfo(const string& file);
 	const CmdDf& getCmdDf(const string& mountpoint) { return cmddfs.get(mountpoint); }
 
 	// The device is only used for the cache-key.
@@ -135,6 +173,18 @@ namespace storage
 	{
 	public:
 
+	    /**
+	     * Returns the object if it was successfully constructed before,
+	     * otherwise nullptr.
+	     */
+	    const Object* peek() const { return object.get(); }
+
+	    void reset()
+	    {
+		object.reset();
+		ep = nullptr;
+	    }
+
 	    const Object& get(Args... args)
 	    {
 		if (ep)
@@ -156,6 +206,25 @@ namespace storage
 		return *object;
 	    }
 
+	    /**
+	     * Constructs the object from ctor_args, replacing a cached object
+	     * or exception.
+	     */
+	    template <typename... CtorArgs>
+	    void emplace(CtorArgs&&... ctor_args)
+	    {
+		try
+		{
+		    object.reset(new Object(std::forward<CtorArgs>(ctor_args)...));
+		    ep = nullptr;
+		}
+		catch (const std::exception& e)
+		{
+		    object.reset();
+		    ep = std::current_exception();
+		}
+	    }
+
 	private:
 
 	    std::shared_ptr<Object> object;
@@ -177,6 +246,11 @@ namespace storage
 
 	    typedef HelperBase<Object, Arg> Helper;
 
+	    bool includes(const Arg& arg) const
+	    {
+		return data.find(arg) != data.end();
+	    }
+
 	    const Object& get(const Arg& arg)
 	    {
 		typename map<Arg, Helper>::iterator pos = data.lower_bound(arg);
@@ -185,6 +259,30 @@ namespace storage
 		return pos->second.get(arg);
 	    }
 
+	    template <typename... CtorArgs>
+	    void emplace(const Arg& arg, CtorArgs&&... ctor_args)
+	    {
+		data[arg].emplace(std::forward<CtorArgs>(ctor_args)...);
+	    }
+
+	    void clear() { data.clear(); }
+
+	    /**
+	     * Removes the objects for which pred returns true. Objects
+	     * whose construction failed are always removed.
+	     */
+	    template <typename Pred>
+	    void erase_if(Pred pred)
+	    {
+		for (typename map<Arg, Helper>::iterator it = data.begin(); it != data.end(); )
+		{
+		    if (!it->second.peek() || pred(it->first, *it->second.peek()))
+			it = data.erase(it);
+		    else
+			++it;
+		}
+	    }
+
 	private:
 
 	    map<Arg, Helper> data;
@@ -215,6 +313,30 @@ namespace storage
 		return pos->second.get(key, args...);
 	    }
 
+	    template <typename... CtorArgs>
+	    void emplace(const Key& key, CtorArgs&&... ctor_args)
+	    {
+		data[key].emplace(std::forward<CtorArgs>(ctor_args)...);
+	    }
+
+	    void clear() { data.clear(); }
+
+	    /**
+	     * Removes the objects for which pred returns true. Objects
+	     * whose construction failed are always removed.
+	     */
+	    template <typename Pred>
+	    void erase_if(Pred pred)
+	    {
+		for (typename map<Key, Helper>::iterator it = data.begin(); it != data.end(); )
+		{
+		    if (!it->second.peek() || pred(it->first, *it->second.peek()))
+			it = data.erase(it);
+		    else
+			++it;
+		}
+	    }
+
 	private:
 
 	    map<Key, Helper> data;
@@ -253,11 +375,26 @@ namespace storage
 	LazyObject<CmdVgs> cmdvgs;
 	LazyObject<CmdLvs> cmdlvs;
 
-	LazyObjects<CmdUdevadmInfo> cmdudevadminfos;
+	LazyObject<CmdUdevadmExportDb> cmd_udevadm_export_db;
+	LazyObjectsWithKey<CmdUdevadmInfo, const CmdUdevadmExportDb*> cmdudevadminfos;
 	LazyObjects<CmdDf> cmddfs;
 
 	LazyObjectsWithKey<CmdLsattr, string, string> cmdlsattr;
 
+	bool is_prefetch_enabled(size_t num_args) const;
+
+	/**
+	 * Runs the commands with the options for args not yet included in
+	 * objects and constructs the objects from the finished commands.
+	 */
+	template <class Objects>
+	void prefetch(Objects& objects, const vector<string>& args,
+		      SystemCmd::Options (*options)(const string& arg));
+
+	unsigned int max_parallel_probes;
+
+	bool batch_mode;
+
     };
 
 }
@@ -120,27 +120,103 @@ namespace storage
 	{
 	    y2mil("saving file " << name);
 
-	    int fd = open(name.c_str(), O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, permissions);
-	    if (fd < 0)
-		ST_THROW(IOException(sformat("Opening file %s failed: %s", name, stringerror(errno))));
+	    if (!replace || !save_by_rename())
+		save_to(name);
+	}
+    }
 
-	    FILE* file = fdopen(fd, "we");
-	    if (!file)
-		ST_THROW(IOException(sformat("Opening file %s failed: %s", name, stringerror(errno))));
 
-	    for (const string& line : lines)
-	    {
-		string line_with_break = line + "\n";
+    bool
+    AsciiFile::save_by_rename() const
+    {
+	// Write a temporary file in the same directory and rename it so that
+	// the file is replaced atomically. Symbolic links and hard links are
+	// kept by writing the file in place.
+
+	struct stat st;
+	bool exists = lstat(name.c_str(), &st) == 0;
 
-		fputs(line_with_break.c_str(), file);
+	if (exists && (S_ISLNK(st.st_mode) || st.st_nlink > 1))
+	    return false;
+
+	string tmp_name = name + ".tmp-" + to_string(getpid());
+
+	// a stale temporary file would keep its owner and permissions
+	unlink(tmp_name.c_str());
+
+	try
+	{
+	    save_to(tmp_name, exists ? &st : nullptr);
+	}
+	catch (const Exception& exception)
+	{
+	    ST_CAUGHT(exception);
+
+	    unlink(tmp_name.c_str());
+
+	    ST_RETHROW(exception);
+	}
+
+	if (rename(tmp_name.c_str(), name.c_str()) != 0)
+	{
+	    int errnum = errno;
+
+	    unlink(tmp_name.c_str());
+
+	    // e.g. a bind mounted file cannot be replaced
+	    if (errnum == EBUSY || errnum == EXDEV)
+	    {
+		y2war("renaming file " << tmp_name << " failed: " << stringerror(errnum));
+		return false;
 	    }
 
-	    if (ferror(file))
-		ST_THROW(IOException(sformat("Saving file %s failed: %s", name, stringerror(errno))));
+	    ST_THROW(IOException(sformat("Renaming file %s failed: %s", tmp_name, stringerror(errnum))));
+	}
 
-	    if (fclose(file) != 0)
-		ST_THROW(IOException(sformat("Closing file %s failed: %s", name, stringerror(errno))));
+	return true;
+    }
+
+
+    void
+    AsciiFile::save_to(const string& filename, const struct stat* st) const
+    {
+	int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, permissions);
+	if (fd < 0)
+	    ST_THROW(IOException(sformat("Opening file %s failed: %s", filename, stringerror(errno))));
+
+	if (st)
+	{
+	    // keep owner and permissions of the replaced file
+
+	    if (fchown(fd, st->st_uid, st->st_gid) != 0)
+		y2war("fchown of " << filename << " failed: " << stringerror(errno));
+
+	    if (fchmod(fd, st->st_mode & 07777) != 0)
+		y2war("fchmod of " << filename << " failed: " << stringerror(errno));
+	}
+
+	FILE* file = fdopen(fd, "we");
+	if (!file)
+	{
+	    close(fd);
+	    ST_THROW(IOException(sformat("Opening file %s failed: %s", filename, stringerror(errno))));
+	}
+
+	for (const string& line : lines)
+	{
+	    fputs(line.c_str(), file);
+	    fputc('\n', file);
 	}
+
+	if (ferror(file) || fflush(file) != 0 || fsync(fd) != 0)
+	{
+	    int errnum = errno;
+	    fclose(file);
+	    ST_THROW(IOException(sformat("Saving file %s failed: %s", filename, stringerror(errnum))));
+	}
+
+	if (fclose(file) != 0)
+	    ST_THROW(IOException(sformat("Closing file %s failed: %s", filename, stringerror(errno))));
     }
 
 
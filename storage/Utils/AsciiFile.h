@@ -25,6 +25,7 @@
 #define STORAGE_ASCII_FILE_H
 
 
+#include <sys/stat.h>
 #include <string>
 #include <vector>
 
@@ -61,6 +62,16 @@ namespace storage
 
 	void set_lines(const vector<string>& lines) { this->lines = lines; }
 
+	/**
+	 * By default the file is written in place. With replace enabled a
+	 * temporary file is written and renamed so that the file is replaced
+	 * atomically. Symbolic links, files with several hard links and
+	 * files that cannot be renamed, e.g. bind mounted files, are still
+	 * written in place. ACLs and extended attributes of a replaced file
+	 * are lost.
+	 */
+	void set_replace(bool replace) { AsciiFile::replace = replace; }
+
     protected:
 
 	// By default, file permissions are only limited by umask value
@@ -72,6 +83,18 @@ namespace storage
 
 	vector<string> lines;
 
+    private:
+
+	bool replace = false;
+
+	/**
+	 * Replaces the file by renaming a temporary file. Returns false if
+	 * the file must be written in place instead.
+	 */
+	bool save_by_rename() const;
+
+	void save_to(const string& filename, const struct stat* st = nullptr) const;
+
     };
 
 }
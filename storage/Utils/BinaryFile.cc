@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fstream>
+
+#include "storage/Utils/BinaryFile.h"
+#include "storage/Utils/ExceptionImpl.h"
+#include "storage/Utils/Format.h"
+
+
+namespace storage
+{
+
+    using namespace BinaryFormat;
+
+
+    void
+    BinaryFileWriter::add_device(const xmlNode* node)
+    {
+	devices.push_back(add_entry(node));
+    }
+
+
+    void
+    BinaryFileWriter::add_holder(const xmlNode* node)
+    {
+	holders.push_back(add_entry(node));
+    }
+
+
+    uint32_t
+    BinaryFileWriter::add_string(const char* s)
+    {
+	unordered_map<string, uint32_t>::const_iterator it = string_ids.find(s);
+	if (it != string_ids.end())
+	    return it->second;
+
+	uint32_t id = string_offsets.size();
+
+	string_offsets.push_back(string_pool.size());
+	string_pool.append(s);
+	string_pool.push_back('\0');
+
+	string_ids.emplace(s, id);
+
+	return id;
+    }
+
+
+    Entry
+    BinaryFileWriter::add_entry(const xmlNode* node)
+    {
+	Entry entry;
+	entry.classname = add_string((const char*) node->name);
+	entry.node = nodes.size();
+
+	add_node(node);
+
+	return entry;
+    }
+
+
+    void
+    BinaryFileWriter::add_node(const xmlNode* node)
+    {
+	size_t pos = nodes.size();
+
+	nodes.push_back({ add_string((const char*) node->name), none, 0 });
+
+	// Same as getChildValue() the value is the content of the first child.
+
+	if (node->children && node->children->type == XML_TEXT_NODE)
+	    nodes[pos].value = add_string(node->children->content ? (const char*) node->children->content : "");
+
+	for (const xmlNode* child = node->children; child; child = child->next)
+	{
+	    if (child->type == XML_ELEMENT_NODE)
+	    {
+		add_node(child);
+		++nodes[pos].num_children;
+	    }
+	}
+    }
+
+
+    bool
+    BinaryFileWriter::save_to_file(const string& filename) const
+    {
+	Header header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.byte_order = byte_order;
+	header.num_strings = string_offsets.size();
+	header.num_devices = devices.size();
+	header.num_holders = holders.size();
+	header.num_nodes = nodes.size();
+	header.string_pool_size = string_pool.size();
+	header.reserved = 0;
+
+	ofstream file(filename, ios::binary | ios::trunc);
+
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) string_offsets.data(), string_offsets.size() * sizeof(uint32_t));
+	file.write((const char*) devices.data(), devices.size() * sizeof(Entry));
+	file.write((const char*) holders.data(), holders.size() * sizeof(Entry));
+	file.write((const char*) nodes.data(), nodes.size() * sizeof(Node));
+	file.write(string_pool.data(), string_pool.size());
+
+	file.close();
+
+	return file.good();
+    }
+
+
+    BinaryFile::BinaryFile(const string& filename)
+	: data(MAP_FAILED), size(0)
+    {
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	    ST_THROW(Exception("failed to open binary file " + filename));
+
+	struct stat buf;
+	if (fstat(fd, &buf) == 0 && buf.st_size > 0)
+	{
+	    size = buf.st_size;
+	    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+
+	close(fd);
+
+	if (data == MAP_FAILED)
+	    ST_THROW(Exception("failed to map binary file " + filename));
+
+	header = (const Header*) data;
+
+	if (size < sizeof(Header) || memcmp(header->magic, magic, sizeof(magic)) != 0)
+	{
+	    munmap(data, size);
+	    ST_THROW(Exception("not a binary devicegraph file " + filename));
+	}
+
+	if (header->version != version || header->byte_order != byte_order)
+	{
+	    munmap(data, size);
+	    ST_THROW(Exception(sformat("unsupported version or byte order of binary file %s",
+				       filename)));
+	}
+
+	// The sizes are calculated with 64 bit to avoid overflows with
+	// corrupt headers.
+
+	uint64_t expected_size = sizeof(Header) +
+	    (uint64_t) header->num_strings * sizeof(uint32_t) +
+	    ((uint64_t) header->num_devices + header->num_holders) * sizeof(Entry) +
+	    (uint64_t) header->num_nodes * sizeof(Node) + header->string_pool_size;
+
+	if (size != expected_size)
+	{
+	    munmap(data, size);
+	    ST_THROW(Exception("corrupt binary file " + filename));
+	}
+
+	string_offsets = (const uint32_t*)(header + 1);
+	devices = (const Entry*)(string_offsets + header->num_strings);
+	holders = devices + header->num_devices;
+	nodes = (const Node*)(holders + header->num_holders);
+	string_pool = (const char*)(nodes + header->num_nodes);
+
+	if (header->string_pool_size > 0 && string_pool[header->string_pool_size - 1] != '\0')
+	{
+	    munmap(data, size);
+	    ST_THROW(Exception("corrupt binary file " + filename));
+	}
+    }
+
+
+    BinaryFile::~BinaryFile()
+    {
+	munmap(data, size);
+    }
+
+
+    bool
+    BinaryFile::is_binary_file(const string& filename)
+    {
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	    return false;
+
+	char buf[sizeof(magic)];
+	bool ret = read(fd, buf, sizeof(buf)) == sizeof(buf) && memcmp(buf, magic, sizeof(magic)) == 0;
+
+	close(fd);
+
+	return ret;
+    }
+
+
+    const char*
+    BinaryFile::get_string(uint32_t id) const
+    {
+	if (id >= header->num_strings || string_offsets[id] >= header->string_pool_size)
+	    ST_THROW(Exception("corrupt binary file, invalid string"));
+
+	return string_pool + string_offsets[id];
+    }
+
+
+    const char*
+    BinaryFile::get_device_classname(size_t i) const
+    {
+	return get_string(devices[i].classname);
+    }
+
+
+    const char*
+    BinaryFile::get_holder_classname(size_t i) const
+    {
+	return get_string(holders[i].classname);
+    }
+
+
+    xmlNode*
+    BinaryFile::get_device_node(size_t i) const
+    {
+	return create_entry_node(devices[i]);
+    }
+
+
+    xmlNode*
+    BinaryFile::get_holder_node(size_t i) const
+    {
+	return create_entry_node(holders[i]);
+    }
+
+
+    xmlNode*
+    BinaryFile::create_entry_node(const Entry& entry) const
+    {
+	uint32_t pos = entry.node;
+	return create_node(pos, header->num_nodes, 0);
+    }
+
+
+    xmlNode*
+    BinaryFile::create_node(uint32_t& pos, uint32_t end, unsigned int depth) const
+    {
+	if (pos >= end)
+	    ST_THROW(Exception("corrupt binary file, invalid node"));
+
+	if (depth >= max_depth)
+	    ST_THROW(Exception("corrupt binary file, nodes nested too deeply"));
+
+	const Node& node = nodes[pos++];
+
+	xmlNode* ret = xmlNewNode(NULL, (const xmlChar*) get_string(node.name));
+
+	try
+	{
+	    if (node.value != none)
+		xmlAddChild(ret, xmlNewText((const xmlChar*) get_string(node.value)));
+
+	    for (uint32_t i = 0; i < node.num_children; ++i)
+		xmlAddChild(ret, create_node(pos, end, depth + 1));
+	}
+	catch (...)
+	{
+	    xmlFreeNode(ret);
+	    throw;
+	}
+
+	return ret;
+    }
+
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#ifndef STORAGE_BINARY_FILE_H
+#define STORAGE_BINARY_FILE_H
+
+
+#include <libxml/tree.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+
+
+namespace storage
+{
+    using namespace std;
+
+
+    /**
+     * Binary representation of a devicegraph. The file consists of a
+     * header followed by the string offset table, the device table, the
+     * holder table, the node table and the string pool. All tables have
+     * fixed size records of 32 bit integers in host byte order so that the
+     * file can be used directly after mapping it into memory.
+     *
+     * The payload of every device and holder is the tree of nodes also used
+     * for the XML format, so converting between the formats is lossless.
+     * All node names and values are kept only once in the string pool.
+     */
+    namespace BinaryFormat
+    {
+	const char magic[8] = { 'L', 'S', 'N', 'G', 'D', 'G', '\r', '\n' };
+
+	const uint32_t version = 1;
+
+	const uint32_t byte_order = 0x01020304;
+
+	const uint32_t none = 0xffffffff;
+
+	/**
+	 * Maximal nesting depth of nodes accepted when reading. The nodes
+	 * of devices and holders are only nested a few levels so this
+	 * only protects against corrupt files.
+	 */
+	const unsigned int max_depth = 100;
+
+	struct Header
+	{
+	    char magic[8];
+	    uint32_t version;
+	    uint32_t byte_order;
+	    uint32_t num_strings;
+	    uint32_t num_devices;
+	    uint32_t num_holders;
+	    uint32_t num_nodes;
+	    uint32_t string_pool_size;
+	    uint32_t reserved;
+	};
+
+	/**
+	 * Entry of the device and holder table. The node is the index of the
+	 * first node of the entry in the node table.
+	 */
+	struct Entry
+	{
+	    uint32_t classname;
+	    uint32_t node;
+	};
+
+	/**
+	 * Entry of the node table. The nodes are stored in pre-order, so the
+	 * children of a node directly follow it. The value is none if the node
+	 * has no text.
+	 */
+	struct Node
+	{
+	    uint32_t name;
+	    uint32_t value;
+	    uint32_t num_children;
+	};
+    }
+
+
+    class BinaryFileWriter : private boost::noncopyable
+    {
+
+    public:
+
+	/**
+	 * Add a device. The name of the node is used as the classname.
+	 */
+	void add_device(const xmlNode* node);
+
+	/**
+	 * Add a holder. The name of the node is used as the classname.
+	 */
+	void add_holder(const xmlNode* node);
+
+	bool save_to_file(const string& filename) const;
+
+    private:
+
+	uint32_t add_string(const char* s);
+
+	BinaryFormat::Entry add_entry(const xmlNode* node);
+
+	void add_node(const xmlNode* node);
+
+	vector<uint32_t> string_offsets;
+	string string_pool;
+	unordered_map<string, uint32_t> string_ids;
+
+	vector<BinaryFormat::Entry> devices;
+	vector<BinaryFormat::Entry> holders;
+	vector<BinaryFormat::Node> nodes;
+
+    };
+
+
+    class BinaryFile : private boost::noncopyable
+    {
+
+    public:
+
+	/**
+	 * Maps the file into memory and checks the header and the sizes of
+	 * the tables.
+	 *
+	 * @throw Exception
+	 */
+	BinaryFile(const string& filename);
+
+	~BinaryFile();
+
+	/**
+	 * Checks whether the file starts with the magic of the binary
+	 * format.
+	 */
+	static bool is_binary_file(const string& filename);
+
+	size_t num_devices() const { return header->num_devices; }
+	size_t num_holders() const { return header->num_holders; }
+
+	const char* get_device_classname(size_t i) const;
+	const char* get_holder_classname(size_t i) const;
+
+	/**
+	 * Creates the node of the device with all children. The node must
+	 * be freed with xmlFreeNode().
+	 *
+	 * @throw Exception
+	 */
+	xmlNode* get_device_node(size_t i) const;
+
+	/**
+	 * Creates the node of the holder with all children. The node must
+	 * be freed with xmlFreeNode().
+	 *
+	 * @throw Exception
+	 */
+	xmlNode* get_holder_node(size_t i) const;
+
+    private:
+
+	const char* get_string(uint32_t id) const;
+
+	xmlNode* create_node(uint32_t& pos, uint32_t end, unsigned int depth) const;
+
+	xmlNode* create_entry_node(const BinaryFormat::Entry& entry) const;
+
+	void* data;
+	size_t size;
+
+	const BinaryFormat::Header* header;
+	const uint32_t* string_offsets;
+	const BinaryFormat::Entry* devices;
+	const BinaryFormat::Entry* holders;
+	const BinaryFormat::Node* nodes;
+	const char* string_pool;
+
+    };
+
+}
+
+
+#endif
@@ -40,7 +40,8 @@ using namespace storage;
 CommentedConfigFile::CommentedConfigFile(int permissions) :
     permissions(permissions),
     comment_marker( "#" ),
-    diff_enabled( false )
+    diff_enabled( false ),
+    replace( false )
 {
 }
 
@@ -155,6 +156,7 @@ void CommentedConfigFile::write( const string & new_filename )
 			 permissions);
 
     ascii_file.set_lines(lines);
+    ascii_file.set_replace(replace);
 
     ascii_file.save();
 }
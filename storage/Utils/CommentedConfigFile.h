@@ -427,6 +427,12 @@ public:
      **/
     void set_diff_enabled( bool enabled = true ) { diff_enabled = enabled; }
 
+    /**
+     * Replace the file atomically when writing it instead of writing it in
+     * place. See AsciiFile::set_replace().
+     **/
+    void set_replace( bool enabled = true ) { replace = enabled; }
+
     /**
      * Diff the current status against the last one saved with save_orig().
      **/
@@ -527,6 +533,7 @@ private:
     int 	    permissions;
     string	    comment_marker;
     bool	    diff_enabled;
+    bool	    replace;
 
     string_vec	    header_comments;
     vector<Entry *> entries;
@@ -22,7 +22,9 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "storage/Utils/Diff.h"
 
@@ -51,10 +53,7 @@ Diff::Diff( const string_vec & lines_a,
     lines_b( lines_b ),
     context_lines( context_lines )
 {
-    Range a( lines_a );
-    Range b( lines_b );
-
-    diff( a, b );
+    diff();
     fix_hunk_overlap();
 }
 
@@ -69,142 +68,289 @@ Diff::get_hunk( int index ) const
 }
 
 
-void Diff::diff( Range a, Range b )
+namespace
 {
-#if VERBOSE
-    cout << "diff a.start: " << a.start << " a.end: " << a.end
-	 << " b.start: " << b.start << " b.end: " << b.end
-	 << endl;
-#endif
+    /**
+     * Myers' O(ND) difference algorithm in linear space, see "An O(ND)
+     * Difference Algorithm and Its Variations", Eugene W. Myers, 1986.
+     *
+     * Works on line ids instead of the lines themselves so that comparing
+     * two lines is cheap. The result is the set of lines only in a
+     * ('changed_a') and the set of lines only in b ('changed_b').
+     **/
+    class Myers
+    {
+    public:
+
+	Myers( const vector<int> & a, const vector<int> & b ):
+	    changed_a( a.size(), false ),
+	    changed_b( b.size(), false ),
+	    a( a ),
+	    b( b ),
+	    offset( b.size() + 1 ),
+	    forward( a.size() + b.size() + 3 ),
+	    backward( a.size() + b.size() + 3 )
+	{
+	    compare( 0, a.size(), 0, b.size() );
+	}
 
-    // Skip common lines at the start
+	vector<bool> changed_a;
+	vector<bool> changed_b;
 
-    while ( a.start <= a.end && b.start <= b.end &&
-	    lines_a[ a.start ] == lines_b[ b.start ] )
-    {
-#if VERBOSE
-	cout << "  common start> " << lines_a[ a.start ] << endl;
-#endif
-	++a.start;
-	++b.start;
-    }
+    private:
 
-    // Skip common lines at the end
+	/**
+	 * Compare a[off_a, lim_a) with b[off_b, lim_b).
+	 **/
+	void compare( int off_a, int lim_a, int off_b, int lim_b );
 
-    while ( a.end > a.start && b.end > b.start &&
-	    lines_a[ a.end ] == lines_b[ b.end ] )
-    {
-#if VERBOSE
-	cout << "  common   end> " << lines_a[ a.end ] << endl;
-#endif
-	--a.end;
-	--b.end;
-    }
+	/**
+	 * Find a point (split_a, split_b) on an optimal path through
+	 * a[off_a, lim_a) and b[off_b, lim_b) by searching from both ends
+	 * until the searches meet in the middle. Both ranges must not be
+	 * empty and must not start or end with a common line.
+	 **/
+	void split( int off_a, int lim_a, int off_b, int lim_b, int & split_a, int & split_b );
 
+	// The furthest reaching paths indexed by diagonal (line in a minus
+	// line in b).
 
-    // Check if there is a diff at all
+	int & fwd( int diagonal ) { return forward[ diagonal + offset ]; }
+	int & bwd( int diagonal ) { return backward[ diagonal + offset ]; }
 
-    if ( a.start <= a.end || b.start <= b.end )
-    {
-	// Find longest common subsequence
+	const vector<int> & a;
+	const vector<int> & b;
+
+	const int offset;
 
-        SubSequence seq = find_common_subsequence( a, b );
+	vector<int> forward;
+	vector<int> backward;
+    };
 
-	if ( seq.len > 0 )
+
+    void Myers::compare( int off_a, int lim_a, int off_b, int lim_b )
+    {
+	// Skip common lines at the start and at the end
+
+	while ( off_a < lim_a && off_b < lim_b && a[ off_a ] == b[ off_b ] )
 	{
-	    // Cut in two parts and recurse
+	    ++off_a;
+	    ++off_b;
+	}
 
-	    diff( Range( a.start, seq.pos_a - 1 ),
-		  Range( b.start, seq.pos_b - 1 ) );
+	while ( off_a < lim_a && off_b < lim_b && a[ lim_a - 1 ] == b[ lim_b - 1 ] )
+	{
+	    --lim_a;
+	    --lim_b;
+	}
 
-	    diff( Range( seq.pos_a + seq.len, a.end ),
-		  Range( seq.pos_b + seq.len, b.end ) );
+	if ( off_a == lim_a )
+	{
+	    for ( int i = off_b; i < lim_b; ++i )
+		changed_b[ i ] = true;
+	}
+	else if ( off_b == lim_b )
+	{
+	    for ( int i = off_a; i < lim_a; ++i )
+		changed_a[ i ] = true;
 	}
 	else
 	{
-	    // Hunk output
+	    int split_a, split_b;
 
-	    Hunk hunk;
+	    split( off_a, lim_a, off_b, lim_b, split_a, split_b );
 
-	    add_lines( hunk.lines_removed, lines_a, a );
-	    add_lines( hunk.lines_added,   lines_b, b );
+	    compare( off_a, split_a, off_b, split_b );
+	    compare( split_a, lim_a, split_b, lim_b );
+	}
+    }
 
-	    hunk.removed_start_pos = a.start;
-	    hunk.added_start_pos   = b.start;
 
-	    // Add context
+    void Myers::split( int off_a, int lim_a, int off_b, int lim_b, int & split_a, int & split_b )
+    {
+	const int dmin = off_a - lim_b;
+	const int dmax = lim_a - off_b;
 
-	    if ( context_lines > 0 )
-	    {
-		Range context;
-
-                if ( a.start > 0 )
-                {
-                    context.start = std::max( 0, a.start - context_lines );
-                    context.end   = std::max( 0, a.start - 1 );
-                    add_lines( hunk.context_lines_before, lines_a, context );
-                }
-
-                if ( a.end < (int) lines_a.size() -1 )
-                {
-                    context.start = std::min( (int) lines_a.size() - 1, a.end + 1 );
-                    context.end   = std::min( (int) lines_a.size() - 1, a.end + context_lines );
-                    add_lines( hunk.context_lines_after, lines_a, context );
-                }
-	    }
+	const int fmid = off_a - off_b;
+	const int bmid = lim_a - lim_b;
 
-	    hunks.push_back( hunk );
-	}
-    }
-}
+	const bool odd = ( fmid - bmid ) & 1;
 
+	int fmin = fmid;
+	int fmax = fmid;
+	int bmin = bmid;
+	int bmax = bmid;
 
-Diff::SubSequence
-Diff::find_common_subsequence( const Range & a, const Range & b )
-{
-    SubSequence seq;
-    int best_len = 0;
+	fwd( fmid ) = off_a;
+	bwd( bmid ) = lim_a;
 
-    for ( int pos_a = a.start; pos_a <= a.end; ++pos_a )
-    {
-	const string & start_line_a = lines_a[ pos_a ];
-
-	for ( int pos_b = b.start; pos_b <= b.end; ++pos_b )
+	while ( true )
 	{
-	    if ( start_line_a == lines_b[ pos_b ] ) // Found a sequence start
+	    // Extend the forward paths by one edit
+
+	    if ( fmin > dmin )
+		fwd( --fmin - 1 ) = -1;
+	    else
+		++fmin;
+
+	    if ( fmax < dmax )
+		fwd( ++fmax + 1 ) = -1;
+	    else
+		--fmax;
+
+	    for ( int d = fmax; d >= fmin; d -= 2 )
 	    {
-		int i = pos_a + 1;
-		int j = pos_b + 1;
+		int i = fwd( d - 1 ) >= fwd( d + 1 ) ? fwd( d - 1 ) + 1 : fwd( d + 1 );
+		int j = i - d;
 
-		while ( i <= a.end && j <= b.end &&
-			lines_a[ i ] == lines_b[ j ] )
+		while ( i < lim_a && j < lim_b && a[ i ] == b[ j ] )
 		{
 		    ++i;
 		    ++j;
 		}
 
-		int len = i - pos_a;
+		fwd( d ) = i;
+
+		if ( odd && bmin <= d && d <= bmax && bwd( d ) <= i )
+		{
+		    split_a = i;
+		    split_b = j;
+		    return;
+		}
+	    }
+
+	    // Extend the backward paths by one edit
+
+	    if ( bmin > dmin )
+		bwd( --bmin - 1 ) = std::numeric_limits<int>::max();
+	    else
+		++bmin;
 
-		if ( len > best_len ) // This sequence is longer than the old one
+	    if ( bmax < dmax )
+		bwd( ++bmax + 1 ) = std::numeric_limits<int>::max();
+	    else
+		--bmax;
+
+	    for ( int d = bmax; d >= bmin; d -= 2 )
+	    {
+		int i = bwd( d - 1 ) < bwd( d + 1 ) ? bwd( d - 1 ) : bwd( d + 1 ) - 1;
+		int j = i - d;
+
+		while ( i > off_a && j > off_b && a[ i - 1 ] == b[ j - 1 ] )
 		{
-		    // Save the sequence we just found
+		    --i;
+		    --j;
+		}
 
-		    best_len  = len;
+		bwd( d ) = i;
 
-                    seq.len   = len;
-                    seq.pos_a = pos_a;
-                    seq.pos_b = pos_b;
+		if ( !odd && fmin <= d && d <= fmax && i <= fwd( d ) )
+		{
+		    split_a = i;
+		    split_b = j;
+		    return;
 		}
 	    }
 	}
     }
 
+}
+
+
+void Diff::diff()
+{
+    // Map the lines to ids so that the diff algorithm only compares
+    // integers.
+
+    std::unordered_map<string, int> ids;
+
+    vector<int> ids_a;
+    vector<int> ids_b;
+
+    ids_a.reserve( lines_a.size() );
+    ids_b.reserve( lines_b.size() );
+
+    for ( const string & line : lines_a )
+	ids_a.push_back( ids.emplace( line, ids.size() ).first->second );
+
+    for ( const string & line : lines_b )
+	ids_b.push_back( ids.emplace( line, ids.size() ).first->second );
+
+    Myers myers( ids_a, ids_b );
+
+    // Every run of changed lines between two common lines is one hunk
+
+    const int size_a = lines_a.size();
+    const int size_b = lines_b.size();
+
+    int pos_a = 0;
+    int pos_b = 0;
+
+    while ( pos_a < size_a || pos_b < size_b )
+    {
+	if ( pos_a < size_a && pos_b < size_b &&
+	     ! myers.changed_a[ pos_a ] && ! myers.changed_b[ pos_b ] )
+	{
+	    ++pos_a;
+	    ++pos_b;
+	    continue;
+	}
+
+	Range a( pos_a, pos_a - 1 );
+	Range b( pos_b, pos_b - 1 );
+
+	while ( pos_a < size_a && myers.changed_a[ pos_a ] )
+	    a.end = pos_a++;
+
+	while ( pos_b < size_b && myers.changed_b[ pos_b ] )
+	    b.end = pos_b++;
+
+	if ( a.empty() && b.empty() )
+	    throw std::logic_error( "inconsistent diff result" );
+
+	add_hunk( a, b );
+    }
+}
+
+
+void Diff::add_hunk( const Range & a, const Range & b )
+{
 #if VERBOSE
-    for ( int i =0; i < best_len; ++i )
-        cout << "  common seq> " << lines_a[ seq.pos_a + i ] << endl;
+    cout << "hunk a.start: " << a.start << " a.end: " << a.end
+	 << " b.start: " << b.start << " b.end: " << b.end
+	 << endl;
 #endif
 
-    return seq;
+    Hunk hunk;
+
+    add_lines( hunk.lines_removed, lines_a, a );
+    add_lines( hunk.lines_added,   lines_b, b );
+
+    hunk.removed_start_pos = a.start;
+    hunk.added_start_pos   = b.start;
+
+    // Add context
+
+    if ( context_lines > 0 )
+    {
+	Range context;
+
+	if ( a.start > 0 )
+	{
+	    context.start = std::max( 0, a.start - context_lines );
+	    context.end   = std::max( 0, a.start - 1 );
+	    add_lines( hunk.context_lines_before, lines_a, context );
+	}
+
+	if ( a.end < (int) lines_a.size() -1 )
+	{
+	    context.start = std::min( (int) lines_a.size() - 1, a.end + 1 );
+	    context.end   = std::min( (int) lines_a.size() - 1, a.end + context_lines );
+	    add_lines( hunk.context_lines_after, lines_a, context );
+	}
+    }
+
+    hunks.push_back( hunk );
 }
 
 
@@ -206,33 +206,16 @@ public:
 
 protected:
     /**
-     * Diff lines betwen start and end and add the result to the internal
-     * hunks.
+     * Diff all lines with Myers' O(ND) algorithm and add the result to the
+     * internal hunks.
      **/
-    void diff( Range a, Range b );
+    void diff();
 
     /**
-     * Helper struct for the find_common_subsequence return values.
+     * Add a hunk with the lines in 'a' removed and the lines in 'b' added
+     * instead.
      **/
-    struct SubSequence
-    {
-        int pos_a;
-        int pos_b;
-        int len;
-
-        SubSequence():
-            pos_a(-1),
-            pos_b(-1),
-            len(0)
-            {}
-    };
-
-    /**
-     * Diff helper: find longest common subsequence between start and
-     * end. Return the length of the sequence. Set the _ret parameters to the
-     * respective position where the sequence was found.
-     **/
-    SubSequence find_common_subsequence( const Range & a, const Range & b );
+    void add_hunk( const Range & a, const Range & b );
 
     /**
      * Make sure hunks don't overlap because of context lines.
@@ -26,6 +26,9 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <boost/graph/breadth_first_search.hpp>
+#include <boost/property_map/property_map.hpp>
 
 
 namespace storage
@@ -81,17 +84,22 @@ namespace storage
      * vertex_index property.  Since some algorithm we use need that property
      * we have to create it ourself.  See:
      * http://www.boost.org/doc/libs/1_56_0/libs/graph/doc/faq.html
+     *
+     * Only needed for algorithms working on the whole graph. For searches
+     * from a single vertex use local_breadth_first_search().
      */
     template <typename Graph>
     class VertexIndexMapGenerator
     {
     public:
 
-	typedef map<typename Graph::vertex_descriptor, typename Graph::vertices_size_type> vertex_index_map_t;
+	typedef std::unordered_map<typename Graph::vertex_descriptor, typename Graph::vertices_size_type> vertex_index_map_t;
 
 	VertexIndexMapGenerator(const Graph& graph)
 	    : graph(graph), vertex_index_property_map(vertex_index_map)
 	{
+	    vertex_index_map.reserve(boost::num_vertices(graph));
+
 	    typename Graph::vertices_size_type cnt = 0;
 
 	    typename Graph::vertex_iterator vi, vi_end;
@@ -114,6 +122,33 @@ namespace storage
 
     };
 
+
+    /*
+     * Breadth first search starting at vertex. Other than
+     * boost::breadth_first_search it does not need a vertex index and does
+     * not initialize a color map for all vertices of the graph. So the
+     * cost only depends on the number of vertices reachable from vertex.
+     */
+    template <typename Graph, typename Visitor>
+    void
+    local_breadth_first_search(const Graph& graph, typename boost::graph_traits<Graph>::vertex_descriptor vertex,
+			       Visitor visitor)
+    {
+	typedef typename boost::graph_traits<Graph>::vertex_descriptor vertex_descriptor;
+
+	// Vertices not in the map are white since operator[] value
+	// initializes the color, and white_color is zero.
+
+	typedef std::unordered_map<vertex_descriptor, boost::default_color_type> color_map_t;
+
+	color_map_t color_map;
+	boost::associative_property_map<color_map_t> color_property_map(color_map);
+
+	boost::queue<vertex_descriptor> queue;
+
+	boost::breadth_first_visit(graph, vertex, queue, visitor, color_property_map);
+    }
+
 }
 
 #endif
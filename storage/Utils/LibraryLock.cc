@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#include "storage/Utils/LibraryLock.h"
+
+
+namespace storage
+{
+
+    std::mutex LibraryLock::mutex;
+
+    thread_local bool LibraryLock::held = false;
+
+
+    LibraryLock::Guard::Guard()
+	: acquired(!held)
+    {
+	if (acquired)
+	{
+	    mutex.lock();
+	    held = true;
+	}
+    }
+
+
+    LibraryLock::Guard::~Guard()
+    {
+	if (acquired)
+	{
+	    held = false;
+	    mutex.unlock();
+	}
+    }
+
+
+    LibraryLock::Unlock::Unlock()
+	: released(held)
+    {
+	if (released)
+	{
+	    held = false;
+	    mutex.unlock();
+	}
+    }
+
+
+    LibraryLock::Unlock::~Unlock()
+    {
+	if (released)
+	{
+	    mutex.lock();
+	    held = true;
+	}
+    }
+
+
+    void
+    LibraryLock::wait(std::condition_variable& cv)
+    {
+	if (!held)
+	    return;
+
+	std::unique_lock<std::mutex> lock(mutex, std::adopt_lock);
+
+	held = false;
+	cv.wait(lock);
+	held = true;
+
+	lock.release();
+    }
+
+}
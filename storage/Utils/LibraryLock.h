@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#ifndef STORAGE_LIBRARY_LOCK_H
+#define STORAGE_LIBRARY_LOCK_H
+
+
+#include <mutex>
+#include <condition_variable>
+#include <boost/noncopyable.hpp>
+
+
+namespace storage
+{
+
+    /**
+     * Lock serializing the execution of library code when actions are
+     * committed by several threads. The lock is only released while
+     * waiting for external programs or devices, see LibraryLock::Unlock.
+     *
+     * Without any thread holding the lock (the usual case) all operations
+     * are no-ops.
+     */
+    class LibraryLock
+    {
+    public:
+
+	/**
+	 * Acquires the lock for the lifetime of the object. Does nothing if
+	 * the current thread already holds the lock.
+	 */
+	class Guard : private boost::noncopyable
+	{
+	public:
+
+	    Guard();
+	    ~Guard();
+
+	private:
+
+	    bool acquired;
+
+	};
+
+	/**
+	 * Releases the lock for the lifetime of the object if the current
+	 * thread holds it.
+	 */
+	class Unlock : private boost::noncopyable
+	{
+	public:
+
+	    Unlock();
+	    ~Unlock();
+
+	private:
+
+	    bool released;
+
+	};
+
+	/**
+	 * Releases the lock while waiting for cv. Returns immediately if
+	 * the current thread does not hold the lock since then no other
+	 * thread can notify cv. Spurious wakeups are possible.
+	 */
+	static void wait(std::condition_variable& cv);
+
+    private:
+
+	static std::mutex mutex;
+
+	static thread_local bool held;
+
+    };
+
+}
+
+#endif
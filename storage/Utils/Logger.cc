@@ -26,10 +26,17 @@
 /* Not technically required, but needed on some UNIX distributions */
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 
 #include "storage/Utils/Logger.h"
+#include "storage/Utils/LoggerImpl.h"
 #include "storage/Utils/AppUtil.h"
 
 
@@ -53,6 +60,8 @@ namespace storage
     set_logger(Logger* logger)
     {
 	current_logger = logger;
+
+	reset_log_level_cache(is_library_logger(logger));
     }
 
 
@@ -92,29 +101,82 @@ namespace storage
     }
 
 
+    /**
+     * Logger writing to a file. The file is kept open and the lines are
+     * collected in a buffer which is written by a background thread, when
+     * the buffer gets large, when a warning or error is logged and when
+     * the logger is destroyed. A rotated log file is detected by comparing
+     * the inode of the open file with the one of the filename.
+     */
     class LogfileLogger : public Logger
     {
     public:
 	LogfileLogger(const std::string& filename, int permissions = DEFAULT_PERMISSIONS);
+	virtual ~LogfileLogger();
 
 	virtual void write(LogLevel log_level, const std::string& component, const std::string& file,
 			   int line, const std::string& function, const std::string& content) override;
 
+	void flush();
+
     private:
 
 	// log file should not be world-readable
 	static const int DEFAULT_PERMISSIONS = 0640;
 
+	// size of the buffer that triggers writing by the background thread
+	static const size_t FLUSH_SIZE = 64 * 1024;
+
+	void write_data(const std::string& data);
+
+	void writer_loop();
+
 	const std::string filename;
 	const int permissions;
+
+	// protects buffer and stop
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::string buffer;
+	bool stop;
+
+	// serializes writing to the file, protects fd
+	std::mutex file_mutex;
+	int fd;
+
+	std::thread writer;
     };
 
 
 
     LogfileLogger::LogfileLogger(const string& filename, int permissions) :
 	filename(filename),
-	permissions(permissions)
+	permissions(permissions),
+	stop(false),
+	fd(-1)
     {
+	writer = std::thread(&LogfileLogger::writer_loop, this);
+    }
+
+
+    LogfileLogger::~LogfileLogger()
+    {
+	// the logger is a static object, so avoid use after destruction
+	if (get_logger() == this)
+	    set_logger(nullptr);
+
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    stop = true;
+	}
+
+	condition.notify_one();
+	writer.join();
+
+	flush();
+
+	if (fd >= 0)
+	    close(fd);
     }
 
 
@@ -122,20 +184,98 @@ namespace storage
     LogfileLogger::write(LogLevel log_level, const std::string& component, const std::string& file,
 			 int line, const std::string& function, const std::string& content)
     {
-	int fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, permissions);
+	const string tmp = datetime(time(nullptr)) + " <" +
+	    std::to_string(static_cast<log_level_underlying_type>(log_level)) + "> [" + component +
+	    "] " + file + "(" + function + "):" + std::to_string(line) + " " + content + "\n";
 
-	if (fd >= 0)
+	size_t size;
+
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    buffer += tmp;
+	    size = buffer.size();
+	}
+
+	// Warnings and errors, e.g. from exceptions, are written
+	// immediately so that nothing is lost if the program terminates.
+
+	if (log_level >= LogLevel::WARNING)
+	    flush();
+	else if (size >= FLUSH_SIZE)
+	    condition.notify_one();
+    }
+
+
+    void
+    LogfileLogger::flush()
+    {
+	std::lock_guard<std::mutex> file_lock(file_mutex);
+
+	string data;
+
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    data.swap(buffer);
+	}
+
+	if (!data.empty())
+	    write_data(data);
+    }
+
+
+    void
+    LogfileLogger::write_data(const string& data)
+    {
+	struct stat st1;
+	struct stat st2;
+
+	if (fd >= 0 && (stat(filename.c_str(), &st1) != 0 || fstat(fd, &st2) != 0 ||
+			st1.st_dev != st2.st_dev || st1.st_ino != st2.st_ino))
 	{
-	    FILE* f = fdopen(fd, "ae");
+	    // log file was rotated or removed
+	    close(fd);
+	    fd = -1;
+	}
 
-	    if (f)
-	    {
-		fprintf(f, "%s <%d> [%s] %s(%s):%d %s\n", datetime(time(nullptr)).c_str(),
-			static_cast<log_level_underlying_type>(log_level), component.c_str(),
-			file.c_str(), function.c_str(), line, content.c_str());
+	if (fd < 0)
+	{
+	    fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, permissions);
+	    if (fd < 0)
+		return;
+	}
 
-		fclose(f);
-	    }
+	const char* p = data.data();
+	size_t left = data.size();
+
+	while (left > 0)
+	{
+	    ssize_t r = ::write(fd, p, left);
+	    if (r < 0 && errno == EINTR)
+		continue;
+	    if (r <= 0)
+		break;
+
+	    p += r;
+	    left -= r;
+	}
+    }
+
+
+    void
+    LogfileLogger::writer_loop()
+    {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (!stop)
+	{
+	    condition.wait_for(lock, std::chrono::seconds(1));
+
+	    if (buffer.empty())
+		continue;
+
+	    lock.unlock();
+	    flush();
+	    lock.lock();
 	}
     }
 
@@ -149,6 +289,26 @@ namespace storage
     }
 
 
+    void
+    flush_logger()
+    {
+	LogfileLogger* logfile_logger = dynamic_cast<LogfileLogger*>(get_logger());
+	if (logfile_logger)
+	    logfile_logger->flush();
+    }
+
+
+    /**
+     * The loggers of the library use Logger::test() whose result never
+     * changes, so it can be cached.
+     */
+    bool
+    is_library_logger(const Logger* logger)
+    {
+	return dynamic_cast<const StdoutLogger*>(logger) || dynamic_cast<const LogfileLogger*>(logger);
+    }
+
+
     Silencer::Silencer()
 	: active(false)
     {
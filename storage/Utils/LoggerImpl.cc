@@ -21,6 +21,9 @@
  */
 
 
+#include <vector>
+#include <memory>
+
 #include "storage/Utils/LoggerImpl.h"
 
 
@@ -32,33 +35,75 @@ namespace storage
     static const string& component = "libstorage";
 
 
+    std::atomic<unsigned int> log_level_cache(0);
+
+    static std::atomic<bool> log_level_cache_enabled(false);
+
+
     bool
-    query_log_level(LogLevel log_level)
+    query_log_level_uncached(LogLevel log_level)
     {
+	bool ret = false;
+
 	Logger* logger = get_logger();
 	if (logger)
 	{
-	    return logger->test(log_level, component);
+	    ret = logger->test(log_level, component);
 	}
 
-	return false;
+	if (log_level_cache_enabled.load(std::memory_order_relaxed))
+	{
+	    const unsigned int shift = 2 * static_cast<unsigned int>(log_level);
+	    log_level_cache.fetch_or((1U << shift) | (ret ? 2U << shift : 0), std::memory_order_relaxed);
+	}
+
+	return ret;
     }
 
 
     void
-    prepare_log_stream(ostringstream& stream)
+    reset_log_level_cache(bool enabled)
+    {
+	log_level_cache_enabled.store(enabled, std::memory_order_relaxed);
+	log_level_cache.store(0, std::memory_order_relaxed);
+    }
+
+
+    namespace
     {
-	stream.imbue(std::locale::classic());
-	stream.setf(std::ios::boolalpha);
-	stream.setf(std::ios::showbase);
+	/**
+	 * Streams reused for log messages. Several streams are needed
+	 * since formatting a log message can log itself.
+	 */
+	struct LogStreams
+	{
+	    vector<unique_ptr<ostringstream>> streams;
+	    size_t used = 0;
+	};
+
+	thread_local LogStreams log_streams;
     }
 
 
     ostringstream*
     open_log_stream()
     {
-	std::ostringstream* stream = new ostringstream;
-	prepare_log_stream(*stream);
+	if (log_streams.used == log_streams.streams.size())
+	{
+	    log_streams.streams.emplace_back(new ostringstream);
+	    log_streams.streams.back()->imbue(std::locale::classic());
+	}
+
+	ostringstream* stream = log_streams.streams[log_streams.used++].get();
+
+	// reset content and formatting left from the previous message
+	stream->str(string());
+	stream->clear();
+	stream->flags(std::ios::dec | std::ios::skipws | std::ios::boolalpha | std::ios::showbase);
+	stream->precision(6);
+	stream->width(0);
+	stream->fill(' ');
+
 	return stream;
     }
 
@@ -70,21 +115,31 @@ namespace storage
 	Logger* logger = get_logger();
 	if (logger)
 	{
-	    string content = stream->str();
-	    string::size_type pos1 = 0;
-	    while (true)
+	    const string content = stream->str();
+
+	    if (content.find('\n') == string::npos)
+	    {
+		if (!content.empty())
+		    logger->write(log_level, component, file, line, func, content);
+	    }
+	    else
 	    {
-		string::size_type pos2 = content.find('\n', pos1);
-		if (pos2 != string::npos || pos1 != content.length())
-		    logger->write(log_level, component, file, line, func,
-				  content.substr(pos1, pos2 - pos1));
-		if (pos2 == string::npos)
-		    break;
-		pos1 = pos2 + 1;
+		string::size_type pos1 = 0;
+		while (true)
+		{
+		    string::size_type pos2 = content.find('\n', pos1);
+		    if (pos2 != string::npos || pos1 != content.length())
+			logger->write(log_level, component, file, line, func,
+				      content.substr(pos1, pos2 - pos1));
+		    if (pos2 == string::npos)
+			break;
+		    pos1 = pos2 + 1;
+		}
 	    }
 	}
 
-	delete stream;
+	if (log_streams.used > 0 && log_streams.streams[log_streams.used - 1].get() == stream)
+	    --log_streams.used;
     }
 
 }
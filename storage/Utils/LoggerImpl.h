@@ -26,6 +26,7 @@
 
 
 #include <sstream>
+#include <atomic>
 
 #include "storage/Utils/Logger.h"
 
@@ -33,13 +34,56 @@
 namespace storage
 {
 
-    bool query_log_level(LogLevel log_level);
+    /**
+     * Cached results of Logger::test() for the log levels. For every log
+     * level two bits are used: the lower one says whether the result is
+     * known, the higher one holds the result. The cache is reset by
+     * set_logger() and only used for the loggers of the library itself
+     * since the result of test() of other loggers may change at any time.
+     */
+    extern std::atomic<unsigned int> log_level_cache;
 
+    bool query_log_level_uncached(LogLevel log_level);
+
+    inline bool
+    query_log_level(LogLevel log_level)
+    {
+	const unsigned int shift = 2 * static_cast<unsigned int>(log_level);
+	const unsigned int cache = log_level_cache.load(std::memory_order_relaxed);
+
+	if (cache & (1U << shift))
+	    return cache & (2U << shift);
+
+	return query_log_level_uncached(log_level);
+    }
+
+    /**
+     * Empties the cache. If enabled is false the results are not cached
+     * until the next call.
+     */
+    void reset_log_level_cache(bool enabled);
+
+    /**
+     * Checks whether the logger is one of the loggers of the library
+     * itself, e.g. the logfile logger.
+     */
+    bool is_library_logger(const Logger* logger);
+
+    /**
+     * Returns a stream to format a log message. The stream is reused
+     * within the thread so close_log_stream() must be called.
+     */
     std::ostringstream* open_log_stream();
 
     void close_log_stream(LogLevel log_level, const char* file, unsigned line,
 			  const char* func, std::ostringstream*);
 
+    /**
+     * Writes buffered log lines of the current logger if it is the
+     * logfile logger.
+     */
+    void flush_logger();
+
 #define y2deb(op) y2log_op(storage::LogLevel::DEBUG, __FILE__, __LINE__, __FUNCTION__, op)
 #define y2mil(op) y2log_op(storage::LogLevel::MILESTONE, __FILE__, __LINE__, __FUNCTION__, op)
 #define y2war(op) y2log_op(storage::LogLevel::WARNING, __FILE__, __LINE__, __FUNCTION__, op)
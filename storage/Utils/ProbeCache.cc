@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fstream>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "storage/Utils/ProbeCache.h"
+#include "storage/Utils/XmlFile.h"
+#include "storage/Utils/ExceptionImpl.h"
+#include "storage/Utils/LoggerImpl.h"
+#include "storage/Utils/AppUtil.h"
+#include "storage/Utils/SystemCmd.h"
+#include "storage/Utils/StorageDefines.h"
+#include "storage/Utils/Format.h"
+
+
+namespace storage
+{
+    using namespace std;
+
+
+    bool ProbeCache::active = false;
+
+    map<string, ProbeCache::Entry> ProbeCache::entries;
+
+
+    namespace
+    {
+
+	string
+	read_first_line(const string& filename)
+	{
+	    ifstream s(filename);
+
+	    string line;
+	    getline(s, line);
+
+	    return line;
+	}
+
+
+	string
+	get_device_key(const string& device)
+	{
+	    struct stat buf;
+
+	    if (stat(device.c_str(), &buf) != 0 || !S_ISBLK(buf.st_mode))
+		return "missing";
+
+	    string majorminor = sformat("%d:%d", major(buf.st_rdev), minor(buf.st_rdev));
+
+	    string size = read_first_line(SYSFS_DIR "/dev/block/" + majorminor + "/size");
+
+	    // The udev database entry is rewritten whenever udev handles an
+	    // event for the device, e.g. after the content of the device was
+	    // modified.
+
+	    string mtime = "unknown";
+
+	    if (stat(("/run/udev/data/b" + majorminor).c_str(), &buf) == 0)
+		mtime = sformat("%d.%09d", buf.st_mtim.tv_sec, buf.st_mtim.tv_nsec);
+
+	    return majorminor + "," + size + "," + mtime;
+	}
+
+
+	bool
+	is_block_device(const string& path)
+	{
+	    struct stat buf;
+
+	    return stat(path.c_str(), &buf) == 0 && S_ISBLK(buf.st_mode);
+	}
+
+
+	bool
+	is_sub_path(const string& path, const string& dir)
+	{
+	    return boost::starts_with(path, dir + "/");
+	}
+
+
+	/**
+	 * Returns all quoted arguments of the command that are absolute
+	 * paths, except /dev/null.
+	 */
+	vector<string>
+	get_path_arguments(const string& name)
+	{
+	    vector<string> paths;
+
+	    for (string::size_type pos1 = name.find("'/"); pos1 != string::npos;
+		 pos1 = name.find("'/", pos1 + 1))
+	    {
+		string::size_type pos2 = name.find('\'', pos1 + 1);
+		if (pos2 == string::npos)
+		    break;
+
+		string path = name.substr(pos1 + 1, pos2 - pos1 - 1);
+		if (path != DEV_DIR "/null")
+		    paths.push_back(path);
+
+		pos1 = pos2;
+	    }
+
+	    return paths;
+	}
+
+    }
+
+
+    bool
+    ProbeCache::is_cacheable(const string& name)
+    {
+	// Commands working on mount points or other directories, e.g. df,
+	// lsattr or btrfs, report data that changes without any uevent.
+
+	for (const string& path : get_path_arguments(name))
+	{
+	    if (!is_sub_path(path, DEV_DIR) && !is_sub_path(path, SYSFS_DIR))
+		return false;
+	}
+
+	return true;
+    }
+
+
+    string
+    ProbeCache::get_key(const string& name)
+    {
+	if (boost::starts_with(name, UDEVADMBIN_SETTLE) || !is_cacheable(name))
+	    return "";
+
+	string key = read_first_line("/proc/sys/kernel/random/boot_id");
+
+	bool devices = false;
+	bool others = false;
+
+	for (const string& path : get_path_arguments(name))
+	{
+	    if (is_block_device(path))
+	    {
+		key += " " + get_device_key(path);
+		devices = true;
+	    }
+	    else
+	    {
+		others = true;
+	    }
+	}
+
+	// Commands without block devices, e.g. blkid or lvs, and commands
+	// on directories in /dev or /sys, e.g. /dev/disk/by-id, or on
+	// missing devices are invalidated by any uevent.
+
+	if (!devices || others)
+	    key += " " + read_first_line(SYSFS_DIR "/kernel/uevent_seqnum");
+
+	return key;
+    }
+
+
+    void
+    ProbeCache::load(const string& filename)
+    {
+	clear();
+
+	active = true;
+
+	if (access(filename.c_str(), R_OK) != 0)
+	{
+	    y2mil("no probe cache " << filename);
+	    return;
+	}
+
+	try
+	{
+	    XmlFile xml(filename);
+
+	    const xmlNode* root_node = xml.getRootElement();
+	    if (!root_node)
+		ST_THROW(Exception("root node not found"));
+
+	    const xmlNode* probe_cache_node = getChildNode(root_node, "ProbeCache");
+	    if (!probe_cache_node)
+		ST_THROW(Exception("ProbeCache node not found"));
+
+	    const xmlNode* commands_node = getChildNode(probe_cache_node, "Commands");
+	    if (commands_node)
+	    {
+		for (const xmlNode* command_node : getChildNodes(commands_node))
+		{
+		    string name;
+		    getChildValue(command_node, "name", name);
+
+		    Entry entry;
+		    entry.used = false;
+		    entry.added = false;
+		    entry.key_pending = false;
+		    getChildValue(command_node, "key", entry.key);
+		    getChildValue(command_node, "stdout", entry.command.stdout);
+		    getChildValue(command_node, "stderr", entry.command.stderr);
+
+		    entries[name] = entry;
+		}
+	    }
+
+	    y2mil("loaded probe cache " << filename << " with " << entries.size() << " entries");
+	}
+	catch (const Exception& exception)
+	{
+	    ST_CAUGHT(exception);
+
+	    y2err("failed to load probe cache " << filename);
+
+	    entries.clear();
+	}
+    }
+
+
+    void
+    ProbeCache::save(const string& filename)
+    {
+	bool dirty = false;
+
+	for (const map<string, Entry>::value_type& it : entries)
+	{
+	    if (it.second.added)
+		dirty = true;
+	}
+
+	active = false;
+
+	if (!dirty)
+	{
+	    entries.clear();
+	    return;
+	}
+
+	try
+	{
+	    // Let udev handle pending uevents before checking the keys. An
+	    // entry whose key changed since its command was run may hold
+	    // outdated output. Commands causing uevents themselves only get
+	    // their key now.
+
+	    SystemCmd(UDEVADMBIN_SETTLE);
+
+	    size_t num_saved = 0;
+
+	    XmlFile xml;
+
+	    xmlNode* probe_cache_node = xmlNewNode("ProbeCache");
+	    xml.setRootElement(probe_cache_node);
+
+	    xmlNode* comment = xmlNewComment(string(" " + generated_string() + " ").c_str());
+	    xmlAddPrevSibling(probe_cache_node, comment);
+
+	    xmlNode* commands_node = xmlNewChild(probe_cache_node, "Commands");
+
+	    for (const map<string, Entry>::value_type& it : entries)
+	    {
+		if (!it.second.used)
+		    continue;
+
+		const string key = get_key(it.first);
+
+		if (key.empty() || (!it.second.key_pending && it.second.key != key))
+		{
+		    y2mil("probe cache entry changed for \"" << it.first << "\"");
+		    continue;
+		}
+
+		xmlNode* command_node = xmlNewChild(commands_node, "Command");
+
+		setChildValue(command_node, "name", it.first);
+		setChildValue(command_node, "key", key);
+		setChildValue(command_node, "stdout", it.second.command.stdout);
+		setChildValue(command_node, "stderr", it.second.command.stderr);
+
+		++num_saved;
+	    }
+
+	    // Write to a temporary file and rename it so that an interrupted
+	    // save does not leave a truncated cache.
+
+	    const string tmp_filename = filename + ".tmp";
+
+	    if (!xml.save_to_file(tmp_filename))
+		ST_THROW(Exception("saving " + tmp_filename + " failed"));
+
+	    if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+	    {
+		unlink(tmp_filename.c_str());
+		ST_THROW(Exception("renaming " + tmp_filename + " failed"));
+	    }
+
+	    y2mil("saved probe cache " << filename << " with " << num_saved << " entries");
+	}
+	catch (const Exception& exception)
+	{
+	    ST_CAUGHT(exception);
+
+	    y2err("failed to save probe cache " << filename);
+	}
+
+	entries.clear();
+    }
+
+
+    void
+    ProbeCache::clear()
+    {
+	active = false;
+
+	entries.clear();
+    }
+
+
+    const ProbeCache::Command*
+    ProbeCache::find_command(const string& name)
+    {
+	if (!is_cacheable(name))
+	    return nullptr;
+
+	map<string, Entry>::iterator it = entries.find(name);
+	if (it == entries.end())
+	    return nullptr;
+
+	// Entries added during this run are valid anyway.
+
+	if (!it->second.added && it->second.key != get_key(name))
+	{
+	    y2mil("probe cache entry outdated for \"" << name << "\"");
+	    entries.erase(it);
+	    return nullptr;
+	}
+
+	y2mil("probe cache hit for \"" << name << "\"");
+
+	it->second.used = true;
+
+	return &it->second.command;
+    }
+
+
+    void
+    ProbeCache::set_command(const string& name, const string& key, const Command& command)
+    {
+	if (command.exit_code != 0 || key.empty())
+	    return;
+
+	entries[name] = { key, command, true, true, false };
+    }
+
+
+    void
+    ProbeCache::set_command_key_pending(const string& name, const Command& command)
+    {
+	if (command.exit_code != 0 || !is_cacheable(name))
+	    return;
+
+	entries[name] = { "", command, true, true, true };
+    }
+
+}
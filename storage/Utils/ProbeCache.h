@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+#ifndef STORAGE_PROBE_CACHE_H
+#define STORAGE_PROBE_CACHE_H
+
+
+#include <string>
+#include <map>
+
+#include "storage/Utils/Remote.h"
+
+
+namespace storage
+{
+    using std::string;
+    using std::map;
+
+
+    /**
+     * Persistent cache for the output of the commands run during
+     * probing. The file has a format similar to the mockup.
+     *
+     * Each entry has a validity key. For commands working on block
+     * devices, e.g. "parted '/dev/sda'", the key is made of the boot id
+     * and for every device its major and minor number, its size and the
+     * time udev last updated its database entry. For all other commands,
+     * e.g. blkid, lvs or "ls '/dev/disk/by-id'", the key additionally
+     * contains the uevent sequence number, so any uevent invalidates
+     * them.
+     *
+     * Commands failing or waiting for udev are not cached. Neither are
+     * commands working on mount points or other directories outside of
+     * /dev and /sys, e.g. df, lsattr or btrfs, since their output changes
+     * without any uevent.
+     *
+     * The key is computed before the command is run, so that a change
+     * while the command is running invalidates the entry. Commands
+     * causing uevents themselves, e.g. parted, are the exception: Their
+     * key is computed when saving, after udev has handled the events.
+     * When saving, entries whose key no longer matches are dropped.
+     */
+    class ProbeCache
+    {
+    public:
+
+	typedef RemoteCommand Command;
+
+	static bool is_active() { return active; }
+
+	/**
+	 * Loads the cache and activates it. A missing or broken file
+	 * results in an empty cache.
+	 */
+	static void load(const string& filename);
+
+	/**
+	 * Saves the cache if anything was added and deactivates it. Only
+	 * entries used or added since loading are saved. Errors are only
+	 * logged.
+	 */
+	static void save(const string& filename);
+
+	/**
+	 * Deactivates and empties the cache.
+	 */
+	static void clear();
+
+	/**
+	 * Returns the cached output of the command or nullptr if the
+	 * command is not cached or the entry is no longer valid.
+	 */
+	static const Command* find_command(const string& name);
+
+	/**
+	 * Returns the validity key for the command, an empty string if the
+	 * command is not cached.
+	 */
+	static string get_key(const string& name);
+
+	/**
+	 * Adds the output of the command. The key must have been computed
+	 * by get_key() before the command was run. Entries with an empty key
+	 * are ignored.
+	 */
+	static void set_command(const string& name, const string& key, const Command& command);
+
+	/**
+	 * Adds the output of a command causing uevents itself. The key is
+	 * computed by save().
+	 */
+	static void set_command_key_pending(const string& name, const Command& command);
+
+    private:
+
+	struct Entry
+	{
+	    string key;
+	    Command command;
+	    bool used;
+	    bool added;
+	    bool key_pending;
+	};
+
+	static bool is_cacheable(const string& name);
+
+	static bool active;
+
+	static map<string, Entry> entries;
+
+    };
+
+}
+
+
+#endif
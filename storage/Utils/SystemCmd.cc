@@ -28,7 +28,10 @@
 #include <ostream>
 #include <fstream>
 #include <sys/wait.h>
+#include <sys/syscall.h>
+#include <spawn.h>
 #include <string>
+#include <string.h>
 #include <sstream>
 #include <boost/algorithm/string.hpp>
 
@@ -42,8 +45,17 @@ extern char **environ;
 #include "storage/Utils/OutputProcessor.h"
 #include "storage/Utils/StorageDefines.h"
 #include "storage/Utils/AppUtil.h"
+#include "storage/Utils/LibraryLock.h"
+#include "storage/Utils/ProbeCache.h"
 
 
+// posix_spawn_file_actions_addclosefrom_np() is available since glibc 2.34.
+#ifdef __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 34)
+#define HAVE_POSIX_SPAWN_CLOSEFROM
+#endif
+#endif
+
 #define SYSCALL_FAILED( SYSCALL_MSG ) \
     ST_MAYBE_THROW( Exception( Exception::strErrno( errno, SYSCALL_MSG ) ), do_throw() )
 
@@ -63,16 +75,8 @@ namespace storage
 
 
     SystemCmd::SystemCmd(const Options& options)
-	: options(options), _combineOutput(false), _execInBackground(false), _cmdRet(0),
-	  _cmdPid(0), _outputProc(nullptr)
+	: SystemCmd(options, Deferred())
     {
-	y2mil("constructor SystemCmd(\"" << command() << "\")");
-
-	if (command().empty())
-            ST_THROW(SystemCmdException(this, "No command specified"));
-
-	init();
-
 	try
 	{
 	    execute();
@@ -84,6 +88,26 @@ namespace storage
 	    ST_RETHROW( exception );
 	}
 
+	checkResult();
+    }
+
+
+    SystemCmd::SystemCmd(const Options& options, Deferred)
+	: options(options), _fromProbeCache(false), _combineOutput(false), _execInBackground(false),
+	  _cmdRet(0), _cmdPid(0), _outputProc(nullptr)
+    {
+	y2mil("constructor SystemCmd(\"" << command() << "\")");
+
+	if (command().empty())
+            ST_THROW(SystemCmdException(this, "No command specified"));
+
+	init();
+    }
+
+
+    void
+    SystemCmd::checkResult() const
+    {
 	if (do_throw() && !options.verify(_cmdRet))
 	{
 	    string s = "command '" + command() + "' failed:\n\n";
@@ -150,6 +174,11 @@ namespace storage
     void
     SystemCmd::closeOpenFds() const
     {
+#ifdef SYS_close_range
+	if (syscall(SYS_close_range, 3, ~0U, 0) == 0)
+	    return;
+#endif
+
 	int max_fd = getdtablesize();
 
 	for ( int fd = 3; fd < max_fd; fd++ )
@@ -159,19 +188,83 @@ namespace storage
     }
 
 
+    int
+    SystemCmd::spawn(const int sin[2], const int sout[2], const int serr[2],
+		     const vector<const char*>& env)
+    {
+#ifdef HAVE_POSIX_SPAWN_CLOSEFROM
+
+	// posix_spawn() does not copy the page tables of the calling
+	// process, which is expensive for large processes, e.g. when
+	// libstorage-ng is used via the bindings.
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+
+	posix_spawn_file_actions_adddup2(&actions, sin[0], STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, sout[1], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, _combineOutput ? STDOUT_FILENO : serr[1],
+					 STDERR_FILENO);
+	posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+
+	const char* argv[] = { SHBIN, "-c", command().c_str(), nullptr };
+
+	pid_t pid;
+	int ret = posix_spawn(&pid, SHBIN, &actions, nullptr, const_cast<char* const*>(argv),
+			      const_cast<char* const*>(&env[0]));
+
+	posix_spawn_file_actions_destroy(&actions);
+
+	if (ret != 0)
+	{
+	    errno = ret;
+	    return -1;
+	}
+
+	return pid;
+
+#else
+
+	int pid = fork();
+	if (pid != 0)
+	    return pid;
+
+	// child process
+
+	// Only async-signal-safe functions may be called in the child
+	// of a multithreaded process. In particular logging is not
+	// allowed since the logger mutex may be held by another thread
+	// of the parent. So on errors the child simply exits.
+
+	if (dup2(sin[0], STDIN_FILENO) < 0)
+	    _exit(SHELL_RET_COMMAND_NOT_FOUND);
+
+	if (dup2(sout[1], STDOUT_FILENO) < 0)
+	    _exit(SHELL_RET_COMMAND_NOT_FOUND);
+
+	if (!_combineOutput && dup2(serr[1], STDERR_FILENO) < 0)
+	    _exit(SHELL_RET_COMMAND_NOT_FOUND);
+
+	if (_combineOutput && dup2(STDOUT_FILENO, STDERR_FILENO) < 0)
+	    _exit(SHELL_RET_COMMAND_NOT_FOUND);
+
+	closeOpenFds();
+	execle(SHBIN, SHBIN, "-c", command().c_str(), nullptr, &env[0]);
+
+	// execle() should not return. If we get here, it failed.
+	_exit(SHELL_RET_COMMAND_NOT_FOUND);
+
+#endif
+    }
+
+
     int
     SystemCmd::execute()
     {
 	// TODO the command handling could need a better concept
 
-	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
-	{
-	    const Mockup::Command& mockup_command = Mockup::get_command(mockup_key());
-	    _outputLines[IDX_STDOUT] = mockup_command.stdout;
-	    _outputLines[IDX_STDERR] = mockup_command.stderr;
-	    _cmdRet = mockup_command.exit_code;
+	if (executeCached())
 	    return 0;
-	}
 
 	int ret;
 
@@ -191,12 +284,61 @@ namespace storage
 	    ret = doExecute();
 	}
 
+	recordResult();
+
+	return ret;
+    }
+
+
+    bool
+    SystemCmd::executeCached()
+    {
+	if (Mockup::get_mode() == Mockup::Mode::PLAYBACK)
+	{
+	    const Mockup::Command& mockup_command = Mockup::get_command(mockup_key());
+	    _outputLines[IDX_STDOUT] = mockup_command.stdout;
+	    _outputLines[IDX_STDERR] = mockup_command.stderr;
+	    _cmdRet = mockup_command.exit_code;
+	    return true;
+	}
+
+	if (ProbeCache::is_active() && !get_remote_callbacks())
+	{
+	    const ProbeCache::Command* cached_command = ProbeCache::find_command(command());
+	    if (cached_command)
+	    {
+		_outputLines[IDX_STDOUT] = cached_command->stdout;
+		_outputLines[IDX_STDERR] = cached_command->stderr;
+		_cmdRet = cached_command->exit_code;
+		_fromProbeCache = true;
+		return true;
+	    }
+
+	    if (!options.causes_uevents)
+		probe_cache_key = ProbeCache::get_key(command());
+	}
+
+	return false;
+    }
+
+
+    void
+    SystemCmd::recordResult() const
+    {
 	if (Mockup::get_mode() == Mockup::Mode::RECORD)
 	{
 	    Mockup::set_command(mockup_key(), Mockup::Command(stdout(), stderr(), retcode()));
 	}
 
-	return ret;
+	if (ProbeCache::is_active() && !get_remote_callbacks())
+	{
+	    ProbeCache::Command cache_command(stdout(), stderr(), retcode());
+
+	    if (options.causes_uevents)
+		ProbeCache::set_command_key_pending(command(), cache_command);
+	    else
+		ProbeCache::set_command(command(), probe_cache_key, cache_command);
+	}
     }
 
 
@@ -329,96 +471,54 @@ namespace storage
 
 	    const vector<const char*> env = make_env();
 
-	    switch( (_cmdPid=fork()) )
+	    _cmdPid = spawn(sin, sout, serr, env);
+
+	    if ( _cmdPid < 0 )
+	    {
+		_cmdRet = -1;
+		SYSCALL_FAILED( "spawn failed" );
+	    }
+	    else
 	    {
-		case 0: // child process
+		if ( close( sin[0] ) < 0 )
+		{
+		    SYSCALL_FAILED_NOTHROW( "close( stdin ) in parent failed" );
+		}
+		if ( close( sout[1] )<0 )
+		{
+		    SYSCALL_FAILED_NOTHROW( "close( stdout ) in parent failed" );
+		}
+		if ( !_combineOutput && close( serr[1] )<0 )
+		{
+		    SYSCALL_FAILED_NOTHROW( "close( stderr ) in parent failed" );
+		}
 
-		    if ( dup2( sin[0], STDIN_FILENO )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "dup2 stdin failed in child process" );
-		    }
-		    if ( dup2( sout[1], STDOUT_FILENO )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "dup2 stdout failed in child process" );
-		    }
-		    if ( !_combineOutput && dup2( serr[1], STDERR_FILENO )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "dup2 stderr failed in child process" );
-		    }
-		    if ( _combineOutput && dup2( STDOUT_FILENO, STDERR_FILENO )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "dup2 stderr failed in child process" );
-		    }
-		    if ( close( sin[1] )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stdin ) failed in child process" );
-		    }
-		    if ( close( sout[0] )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stdout ) failed in child process" );
-		    }
-		    if ( !_combineOutput && close( serr[0] )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stderr ) failed in child process" );
-		    }
-		    closeOpenFds();
-		    _cmdRet = execle(SHBIN, SHBIN, "-c", command().c_str(), nullptr, &env[0]);
-
-		    // execle() should not return. If we get here, it failed.
-		    // Throwing an exception here would not make any sense, however:
-		    // We are in the forked child process, and there is nothing
-		    // to return to that could make use of an exception.
-		    y2err("execle() failed: THIS SHOULD NOT HAPPEN \"SHBIN\" Ret:" <<
-			  _cmdRet << " errno: " << errno);
-		    y2err( "Exiting child process" );
-		    exit(127); // same as "command not found" in the shell
-		    break;
-
-		case -1:
-		    _cmdRet = -1;
-		    SYSCALL_FAILED( "fork() failed" );
-		    break;
-
-		default: // parent process
-		    if ( close( sin[0] ) < 0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stdin ) in parent failed" );
-		    }
-		    if ( close( sout[1] )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stdout ) in parent failed" );
-		    }
-		    if ( !_combineOutput && close( serr[1] )<0 )
-		    {
-			SYSCALL_FAILED_NOTHROW( "close( stderr ) in parent failed" );
-		    }
-		    _cmdRet = 0;
+		_cmdRet = 0;
 
-                    _childStdin = fdopen( sin[1], "a" );
-		    if ( _childStdin == NULL )
-		    {
-			SYSCALL_FAILED_NOTHROW( "fdopen( stdin ) failed" );
-		    }
+		_childStdin = fdopen( sin[1], "a" );
+		if ( _childStdin == NULL )
+		{
+		    SYSCALL_FAILED_NOTHROW( "fdopen( stdin ) failed" );
+		}
 
-		    _files[IDX_STDOUT] = fdopen( sout[0], "r" );
-		    if ( _files[IDX_STDOUT] == NULL )
-		    {
-			SYSCALL_FAILED_NOTHROW( "fdopen( stdout ) failed" );
-		    }
-		    if ( !_combineOutput )
-		    {
-			_files[IDX_STDERR] = fdopen( serr[0], "r" );
-			if ( _files[IDX_STDERR] == NULL )
-			{
-			    SYSCALL_FAILED_NOTHROW( "fdopen( stderr ) failed" );
-			}
-		    }
-		    if ( !_execInBackground )
+		_files[IDX_STDOUT] = fdopen( sout[0], "r" );
+		if ( _files[IDX_STDOUT] == NULL )
+		{
+		    SYSCALL_FAILED_NOTHROW( "fdopen( stdout ) failed" );
+		}
+		if ( !_combineOutput )
+		{
+		    _files[IDX_STDERR] = fdopen( serr[0], "r" );
+		    if ( _files[IDX_STDERR] == NULL )
 		    {
-			doWait( true, _cmdRet );
-			y2mil("stopwatch " << stopwatch << " for \"" << command() << "\"");
+			SYSCALL_FAILED_NOTHROW( "fdopen( stderr ) failed" );
 		    }
-		    break;
+		}
+		if ( !_execInBackground )
+		{
+		    doWait( true, _cmdRet );
+		    y2mil("stopwatch " << stopwatch << " for \"" << command() << "\"");
+		}
 	    }
 	}
 	else if ( !_testmode )
@@ -453,7 +553,11 @@ namespace storage
 	{
 	    y2deb("[0] id:" <<	_pfds[1].fd << " ev:" << hex << (unsigned)_pfds[1].events << dec << " [1] fs:" <<
 		  (_combineOutput?-1:_pfds[2].fd) << " ev:" << hex << (_combineOutput?0:(unsigned)_pfds[2].events));
-	    int sel = poll( _pfds, _combineOutput?2:3, 1000 );
+	    int sel;
+	    {
+		LibraryLock::Unlock unlock;
+		sel = poll( _pfds, _combineOutput?2:3, 1000 );
+	    }
 	    if (sel < 0)
 	    {
 		SYSCALL_FAILED_NOTHROW( "poll() failed" );
@@ -472,44 +576,7 @@ namespace storage
 	while ( hang && waitpidRet == 0 );
 
 	if ( waitpidRet != 0 )
-	{
-	    checkOutput();
-            if ( _childStdin )
-            {
-                fclose( _childStdin );
-                _childStdin = NULL;
-            }
-	    fclose( _files[IDX_STDOUT] );
-	    _files[IDX_STDOUT] = NULL;
-	    if ( !_combineOutput )
-	    {
-		fclose( _files[IDX_STDERR] );
-		_files[IDX_STDERR] = NULL;
-	    }
-	    if (WIFEXITED(cmdStatus))
-	    {
-		cmdRet_ret = WEXITSTATUS(cmdStatus);
-		if ( cmdRet_ret == SHELL_RET_COMMAND_NOT_EXECUTABLE )
-		    ST_MAYBE_THROW(SystemCmdException(this, "Command not executable"), do_throw());
-		else if ( cmdRet_ret == SHELL_RET_COMMAND_NOT_FOUND )
-		    ST_MAYBE_THROW(CommandNotFoundException(this), do_throw());
-		else if ( cmdRet_ret > SHELL_RET_SIGNAL )
-		{
-		    std::stringstream msg;
-		    msg << "Caught signal #" << ( cmdRet_ret - SHELL_RET_SIGNAL );
-		    ST_MAYBE_THROW( SystemCmdException(this, msg.str()), do_throw());
-		}
-	    }
-	    else
-	    {
-		cmdRet_ret = -127;
-		ST_MAYBE_THROW(SystemCmdException(this, "Command failed"), do_throw());
-	    }
-	    if ( _outputProc )
-	    {
-		_outputProc->finish();
-	    }
-	}
+	    processExit( cmdStatus, cmdRet_ret );
 
 	y2deb("Wait:" << waitpidRet << " pid:" << _cmdPid << " stat:" << cmdStatus <<
 	      " Hang:" << hang << " Ret:" << cmdRet_ret);
@@ -517,6 +584,48 @@ namespace storage
     }
 
 
+    void
+    SystemCmd::processExit( int cmdStatus, int& cmdRet_ret )
+    {
+	checkOutput();
+	if ( _childStdin )
+	{
+	    fclose( _childStdin );
+	    _childStdin = NULL;
+	}
+	fclose( _files[IDX_STDOUT] );
+	_files[IDX_STDOUT] = NULL;
+	if ( !_combineOutput )
+	{
+	    fclose( _files[IDX_STDERR] );
+	    _files[IDX_STDERR] = NULL;
+	}
+	if (WIFEXITED(cmdStatus))
+	{
+	    cmdRet_ret = WEXITSTATUS(cmdStatus);
+	    if ( cmdRet_ret == SHELL_RET_COMMAND_NOT_EXECUTABLE )
+		ST_MAYBE_THROW(SystemCmdException(this, "Command not executable"), do_throw());
+	    else if ( cmdRet_ret == SHELL_RET_COMMAND_NOT_FOUND )
+		ST_MAYBE_THROW(CommandNotFoundException(this), do_throw());
+	    else if ( cmdRet_ret > SHELL_RET_SIGNAL )
+	    {
+		std::stringstream msg;
+		msg << "Caught signal #" << ( cmdRet_ret - SHELL_RET_SIGNAL );
+		ST_MAYBE_THROW( SystemCmdException(this, msg.str()), do_throw());
+	    }
+	}
+	else
+	{
+	    cmdRet_ret = -127;
+	    ST_MAYBE_THROW(SystemCmdException(this, "Command failed"), do_throw());
+	}
+	if ( _outputProc )
+	{
+	    _outputProc->finish();
+	}
+    }
+
+
     void
     SystemCmd::invalidate()
     {
@@ -568,7 +677,7 @@ namespace storage
     }
 
 
-#define BUF_LEN 256
+#define BUF_LEN 65536
 
     void
     SystemCmd::getUntilEOF( FILE* file, vector<string>& lines,
@@ -576,54 +685,27 @@ namespace storage
     {
 	size_t oldSize = lines.size();
 	char buffer[BUF_LEN];
-	int count;
-	int c;
-	string text;
+	int fd = fileno(file);
 
-	clearerr( file );
-	count = 0;
-	c = EOF;
-	while ( (c=fgetc(file)) != EOF )
+	// The pipe is non-blocking so read() returns with EAGAIN once
+	// everything available has been consumed.
+	while (true)
 	{
-	    buffer[count++] = c;
-	    if ( count==sizeof(buffer)-1 )
-	    {
-		buffer[count] = 0;
-		extractNewline( buffer, count, newLineSeen_ret, text, lines );
-		count = 0;
-		if ( _outputProc )
-		{
-		    _outputProc->process( buffer, isStderr );
-		}
-	    }
-	    c = EOF;
-	}
-	if ( count>0 )
-	{
-	    buffer[count] = 0;
-	    extractNewline( buffer, count, newLineSeen_ret, text, lines );
+	    ssize_t count = read(fd, buffer, sizeof(buffer));
+	    if (count < 0 && errno == EINTR)
+		continue;
+	    if (count <= 0)
+		break;
+
+	    extractNewline(buffer, count, newLineSeen_ret, lines);
+
 	    if ( _outputProc )
 	    {
-		_outputProc->process( buffer, isStderr );
-	    }
-	}
-	if ( text.length() > 0 )
-	{
-	    if ( newLineSeen_ret )
-	    {
-		addLine( text, lines );
+		_outputProc->process( string(buffer, count), isStderr );
 	    }
-	    else
-	    {
-		lines[lines.size()-1] += text;
-	    }
-	    newLineSeen_ret = false;
 	}
-	else
-	{
-	    newLineSeen_ret = true;
-	}
-	y2deb("text:" << text << " NewLine:" << newLineSeen_ret);
+
+	y2deb("NewLine:" << newLineSeen_ret);
 	if ( oldSize != lines.size() )
 	{
 	    y2mil("pid:" << _cmdPid << " added lines:" << lines.size() - oldSize << " stderr:" << isStderr);
@@ -632,42 +714,51 @@ namespace storage
 
 
     void
-    SystemCmd::extractNewline(const string& buffer, int count, bool& newLineSeen_ret,
-			      string& text, vector<string>& lines) const
+    SystemCmd::extractNewline(const char* buffer, size_t count, bool& newLineSeen_ret,
+			      vector<string>& lines) const
     {
-	string::size_type index;
+	// Split the block in a single pass. An incomplete last line is
+	// already added to lines and completed by the next block.
+
+	const char* pos = buffer;
+	const char* end = buffer + count;
 
-	text += buffer;
-	while ( (index=text.find( '\n' )) != string::npos )
+	while (pos != end)
 	{
-	    if ( !newLineSeen_ret )
-	    {
-		lines[lines.size()-1] += text.substr( 0, index );
-	    }
+	    const char* eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+	    const char* stop = eol ? eol : end;
+
+	    if (!newLineSeen_ret)
+		lines.back().append(pos, stop);
 	    else
-	    {
-		addLine( text.substr( 0, index ), lines );
-	    }
-	    text.erase( 0, index+1 );
-	    newLineSeen_ret = true;
+		addLine(string(pos, stop), lines);
+
+	    newLineSeen_ret = eol != nullptr;
+
+	    if (!eol)
+		break;
+
+	    pos = eol + 1;
 	}
-	y2deb("text: \"" << text << "\" newLineSeen: " << newLineSeen_ret);
     }
 
 
     void
-    SystemCmd::addLine(const string& text, vector<string>& lines) const
+    SystemCmd::addLine(string&& text, vector<string>& lines) const
     {
-	if (lines.size() < options.log_line_limit)
+	if (options.log_lines)
 	{
-	    y2mil("Adding Line " << lines.size() + 1 << " \"" << text << "\"");
-	}
-	else
-	{
-	    y2deb("Adding Line " << lines.size() + 1 << " \"" << text << "\"");
+	    if (lines.size() < options.log_line_limit)
+	    {
+		y2mil("Adding Line " << lines.size() + 1 << " \"" << text << "\"");
+	    }
+	    else
+	    {
+		y2deb("Adding Line " << lines.size() + 1 << " \"" << text << "\"");
+	    }
 	}
 
-	lines.push_back(text);
+	lines.push_back(std::move(text));
     }
 
 
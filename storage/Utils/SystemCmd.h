@@ -42,6 +42,7 @@ namespace storage
     using std::vector;
 
     class OutputProcessor;
+    class SystemCmdGroup;
 
 
     /**
@@ -61,8 +62,8 @@ namespace storage
 	{
 	    Options(const string& command, ThrowBehaviour throw_behaviour = NoThrow)
 		: command(command), throw_behaviour(throw_behaviour), stdin_text(),
-		  mockup_key(), log_line_limit(1000),
-		  verify([](int exit_code){ return exit_code == 0; }) {}
+		  mockup_key(), log_line_limit(1000), log_lines(true),
+		  verify([](int exit_code){ return exit_code == 0; }), causes_uevents(false) {}
 
 	    /**
 	     * The command to be executed.
@@ -89,6 +90,13 @@ namespace storage
 	     */
 	    unsigned int log_line_limit;
 
+	    /**
+	     * Log every output line while it is read. Commands with huge
+	     * output can disable this, the output is still logged (limited
+	     * by log_line_limit) when the command has finished.
+	     */
+	    bool log_lines;
+
 	    /**
 	     * If throw_behaviour is DoThrow this function is used
 	     * additionally to verify if the command succeeded and if not an
@@ -96,6 +104,12 @@ namespace storage
 	     */
 	    std::function<bool(int)> verify;
 
+	    /**
+	     * The command itself causes uevents, e.g. parted since it opens
+	     * devices read-write. Used by the probe cache.
+	     */
+	    bool causes_uevents;
+
 	};
 
 	/**
@@ -175,6 +189,12 @@ namespace storage
 	 */
 	int retcode() const { return _cmdRet; }
 
+	/**
+	 * Return whether the output was taken from the probe cache instead
+	 * of running the command.
+	 */
+	bool is_from_probe_cache() const { return _fromProbeCache; }
+
     public:
 
 	/**
@@ -196,14 +216,20 @@ namespace storage
 	void invalidate();
 	void closeOpenFds() const;
 	int doExecute();
+	bool executeCached();
+	void recordResult() const;
+	void checkResult() const;
+	void processExit(int cmdStatus, int& cmdRet_ret);
+	int spawn(const int sin[2], const int sout[2], const int serr[2],
+		  const vector<const char*>& env);
 	bool doWait(bool hang, int& cmdRet_ret);
 	void checkOutput();
         void sendStdin();
 	void getUntilEOF(FILE* file, std::vector<string>& lines,
 			 bool& newLineSeen_ret, bool isStderr) const;
-	void extractNewline(const string& buffer, int count, bool& newLineSeen_ret,
-			    string& text, std::vector<string>& lines) const;
-	void addLine(const string& text, std::vector<string>& lines) const;
+	void extractNewline(const char* buffer, size_t count, bool& newLineSeen_ret,
+			    std::vector<string>& lines) const;
+	void addLine(string&& text, std::vector<string>& lines) const;
 
 	void logOutput() const;
 
@@ -218,6 +244,14 @@ namespace storage
 
 	Options options;
 
+	/**
+	 * Validity key for the probe cache, computed before running the
+	 * command.
+	 */
+	string probe_cache_key;
+
+	bool _fromProbeCache;
+
 	FILE* _files[2];
         FILE* _childStdin;
 	std::vector<string> _outputLines[2];
@@ -241,6 +275,18 @@ namespace storage
 	 */
 	vector<const char*> make_env() const;
 
+    private:
+
+	friend class SystemCmdGroup;
+
+	struct Deferred {};
+
+	/**
+	 * Constructor that does not execute the command. Used by
+	 * SystemCmdGroup.
+	 */
+	SystemCmd(const Options& options, Deferred);
+
     };
 
 
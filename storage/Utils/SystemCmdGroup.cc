@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+
+#include "storage/Utils/SystemCmdGroup.h"
+#include "storage/Utils/ExceptionImpl.h"
+#include "storage/Utils/LoggerImpl.h"
+#include "storage/Utils/LibraryLock.h"
+#include "storage/Utils/Remote.h"
+
+
+namespace storage
+{
+    using namespace std;
+
+
+    SystemCmdGroup::SystemCmdGroup()
+	: epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+    {
+	if (epoll_fd < 0)
+	    ST_THROW(Exception(Exception::strErrno(errno, "epoll_create1 failed")));
+    }
+
+
+    SystemCmdGroup::~SystemCmdGroup()
+    {
+	close(epoll_fd);
+
+	for (const unique_ptr<Entry>& entry : entries)
+	{
+	    if (entry->running)
+	    {
+		y2war("waiting for unfinished command pid:" << entry->cmd->_cmdPid);
+		entry->cmd->cleanup();
+
+		LibraryLock::Unlock unlock;
+
+		waitpid(entry->cmd->_cmdPid, nullptr, 0);
+	    }
+	}
+    }
+
+
+    const SystemCmd&
+    SystemCmdGroup::start(const SystemCmd::Options& options, Callback callback)
+    {
+	entries.emplace_back(new Entry(new SystemCmd(options, SystemCmd::Deferred()), callback));
+
+	Entry* entry = entries.back().get();
+	SystemCmd& cmd = *entry->cmd;
+
+	try
+	{
+	    if (cmd.executeCached())
+	    {
+		finished.push_back(entry);
+		return cmd;
+	    }
+
+	    if (get_remote_callbacks())
+	    {
+		cmd.execute();
+		finished.push_back(entry);
+		return cmd;
+	    }
+
+	    cmd.executeBackground();
+	}
+	catch (const Exception& exception)
+	{
+	    ST_CAUGHT(exception);
+	    entries.pop_back();
+	    ST_RETHROW(exception);
+	}
+
+	if (cmd._cmdPid <= 0)
+	{
+	    // starting failed and the command does not throw
+	    cmd.recordResult();
+	    finished.push_back(entry);
+	    return cmd;
+	}
+
+	entry->running = true;
+
+	if (cmd._childStdin)
+	    add_fd(cmd._pfds[0].fd, EPOLLOUT, entry);
+	add_fd(cmd._pfds[1].fd, EPOLLIN, entry);
+	add_fd(cmd._pfds[2].fd, EPOLLIN, entry);
+
+	return cmd;
+    }
+
+
+    void
+    SystemCmdGroup::wait(size_t max_running)
+    {
+	while (true)
+	{
+	    while (!finished.empty())
+	    {
+		Entry* entry = finished.front();
+		finished.pop_front();
+
+		entry->cmd->checkResult();
+
+		if (entry->callback)
+		    entry->callback(*entry->cmd);
+	    }
+
+	    if (num_running() <= max_running)
+		break;
+
+	    struct epoll_event events[16];
+	    int n;
+
+	    {
+		LibraryLock::Unlock unlock;
+
+		// The timeout limits the delay for detecting commands that
+		// exit without closing their output.
+		n = epoll_wait(epoll_fd, events, 16, 100);
+	    }
+
+	    if (n < 0 && errno != EINTR)
+		ST_THROW(Exception(Exception::strErrno(errno, "epoll_wait failed")));
+
+	    for (int i = 0; i < n; ++i)
+	    {
+		int fd = events[i].data.fd;
+
+		map<int, Entry*>::const_iterator it = fds.find(fd);
+		if (it == fds.end())
+		    continue;
+
+		SystemCmd& cmd = *it->second->cmd;
+
+		if (fd == cmd._pfds[0].fd && cmd._childStdin)
+		{
+		    cmd.sendStdin();
+
+		    // sendStdin() closes the pipe when everything is sent,
+		    // the kernel removes it from the epoll set
+		    if (!cmd._childStdin)
+			fds.erase(fd);
+		}
+		else
+		{
+		    cmd.checkOutput();
+
+		    if (events[i].events & (EPOLLHUP | EPOLLERR))
+			remove_fd(fd);
+		}
+	    }
+
+	    for (const unique_ptr<Entry>& entry : entries)
+	    {
+		if (entry->running)
+		    check_exit(entry.get());
+	    }
+	}
+    }
+
+
+    size_t
+    SystemCmdGroup::num_running() const
+    {
+	size_t ret = 0;
+
+	for (const unique_ptr<Entry>& entry : entries)
+	{
+	    if (entry->running)
+		++ret;
+	}
+
+	return ret;
+    }
+
+
+    void
+    SystemCmdGroup::add_fd(int fd, uint32_t events, Entry* entry)
+    {
+	struct epoll_event event;
+	event.events = events;
+	event.data.fd = fd;
+
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+	    ST_THROW(Exception(Exception::strErrno(errno, "epoll_ctl failed")));
+
+	fds[fd] = entry;
+    }
+
+
+    void
+    SystemCmdGroup::remove_fd(int fd)
+    {
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+
+	fds.erase(fd);
+    }
+
+
+    bool
+    SystemCmdGroup::check_exit(Entry* entry)
+    {
+	SystemCmd& cmd = *entry->cmd;
+
+	int cmd_status = 0;
+	int ret = waitpid(cmd._cmdPid, &cmd_status, WNOHANG);
+	if (ret == 0)
+	    return false;
+
+	if (ret < 0)
+	    y2err(Exception::strErrno(errno, "waitpid failed"));
+
+	for (map<int, Entry*>::iterator it = fds.begin(); it != fds.end(); )
+	{
+	    if (it->second == entry)
+	    {
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+		it = fds.erase(it);
+	    }
+	    else
+	    {
+		++it;
+	    }
+	}
+
+	entry->running = false;
+
+	cmd.processExit(cmd_status, cmd._cmdRet);
+
+	y2mil("pid:" << cmd._cmdPid << " command:\"" << cmd.command() << "\" Returns:" << cmd._cmdRet);
+	if (cmd._cmdRet != 0)
+	    cmd.logOutput();
+
+	cmd.recordResult();
+
+	finished.push_back(entry);
+
+	return true;
+    }
+
+}
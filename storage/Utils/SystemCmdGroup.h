@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 SUSE LLC
+ *
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, contact SUSE LLC.
+ *
+ * To contact SUSE LLC about this file by physical or electronic mail, you may
+ * find current contact information at www.suse.com.
+ */
+
+
+
+
+#ifndef STORAGE_SYSTEM_CMD_GROUP_H
+#define STORAGE_SYSTEM_CMD_GROUP_H
+
+
+#include <map>
+#include <list>
+#include <memory>
+#include <functional>
+#include <boost/noncopyable.hpp>
+
+#include "storage/Utils/SystemCmd.h"
+
+
+namespace storage
+{
+
+    /**
+     * Class to run several commands concurrently. The output of all
+     * commands is collected by a single epoll loop.
+     *
+     * Mockup playback, recording and the probe cache work as for
+     * SystemCmd. Commands served from the mockup or the probe cache are
+     * finished immediately.
+     */
+    class SystemCmdGroup : private boost::noncopyable
+    {
+    public:
+
+	typedef std::function<void(const SystemCmd& cmd)> Callback;
+
+	SystemCmdGroup();
+
+	/**
+	 * Waits for commands still running. Callbacks are not called
+	 * anymore.
+	 */
+	~SystemCmdGroup();
+
+	/**
+	 * Start the command. The returned object is owned by the group
+	 * and its output and exit code are only valid once the command has
+	 * finished, so after the callback was called or wait() returned.
+	 *
+	 * Throws (like the SystemCmd constructor) if the command cannot be
+	 * started or is missing in the mockup.
+	 */
+	const SystemCmd& start(const SystemCmd::Options& options, Callback callback = nullptr);
+
+	/**
+	 * Wait until at most max_running started commands are still running,
+	 * by default until all have finished. The callbacks are called in
+	 * the order the commands finish.
+	 *
+	 * For commands with throw behaviour DoThrow the same exceptions as
+	 * from the SystemCmd constructor are thrown. Remaining commands can
+	 * be waited for by calling wait() again.
+	 */
+	void wait(size_t max_running = 0);
+
+	/**
+	 * Number of commands not yet finished.
+	 */
+	size_t num_running() const;
+
+    private:
+
+	struct Entry
+	{
+	    Entry(SystemCmd* cmd, Callback callback)
+		: cmd(cmd), callback(callback), running(false) {}
+
+	    std::unique_ptr<SystemCmd> cmd;
+	    Callback callback;
+	    bool running;
+	};
+
+	void add_fd(int fd, uint32_t events, Entry* entry);
+	void remove_fd(int fd);
+
+	bool check_exit(Entry* entry);
+
+	int epoll_fd;
+
+	std::list<std::unique_ptr<Entry>> entries;
+
+	/**
+	 * Finished commands whose callbacks have not been called yet.
+	 */
+	std::list<Entry*> finished;
+
+	std::map<int, Entry*> fds;
+
+    };
+
+}
+
+
+#endif
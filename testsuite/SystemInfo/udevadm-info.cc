@@ -6,6 +6,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "storage/SystemInfo/CmdUdevadm.h"
+#include "storage/SystemInfo/CmdParted.h"
 #include "storage/Utils/Mockup.h"
 #include "storage/Utils/SystemCmd.h"
 #include "storage/Utils/StorageDefines.h"
@@ -203,3 +204,107 @@ BOOST_AUTO_TEST_CASE(parse2)
 
     check("/dev/sda1", input, output);
 }
+
+
+BOOST_AUTO_TEST_CASE(parse_export_db)
+{
+    vector<string> input = {
+	"P: /devices/virtual/net/lo",
+	"E: DEVPATH=/devices/virtual/net/lo",
+	"E: INTERFACE=lo",
+	"E: SUBSYSTEM=net",
+	"",
+	"P: /devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda",
+	"N: sda",
+	"S: disk/by-id/wwn-0x50014ee203733bb5",
+	"S: disk/by-path/pci-0000:00:1f.2-ata-1",
+	"E: DEVTYPE=disk",
+	"E: MAJOR=8",
+	"E: MINOR=0",
+	"E: SUBSYSTEM=block",
+	"",
+	"P: /devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda/sda1",
+	"N: sda1",
+	"S: disk/by-id/wwn-0x50014ee203733bb5-part1",
+	"S: disk/by-uuid/14875716-b8e3-4c83-ac86-48c20682b63a",
+	"E: DEVTYPE=partition",
+	"E: MAJOR=8",
+	"E: MINOR=1",
+	"E: SUBSYSTEM=block",
+	""
+    };
+
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+    Mockup::set_command(UDEVADMBIN " info --export-db", input);
+
+    BOOST_CHECK(CmdUdevadmExportDb::is_usable());
+
+    CmdUdevadmExportDb cmd_udevadm_export_db;
+
+    BOOST_CHECK(!cmd_udevadm_export_db.find("/dev/lo"));
+    BOOST_CHECK(!cmd_udevadm_export_db.find("/dev/sdb"));
+
+    ostringstream parsed1;
+    parsed1 << CmdUdevadmInfo("/dev/disk/by-uuid/14875716-b8e3-4c83-ac86-48c20682b63a", &cmd_udevadm_export_db);
+
+    BOOST_CHECK_EQUAL(parsed1.str(), "file:/dev/disk/by-uuid/14875716-b8e3-4c83-ac86-48c20682b63a "
+		      "path:/devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda/sda1 "
+		      "name:sda1 majorminor:8:1 device-type:partition by-id-links:<wwn-0x50014ee203733bb5-part1>\n");
+
+    ostringstream parsed2;
+    parsed2 << CmdUdevadmInfo("/dev/sda", &cmd_udevadm_export_db);
+
+    BOOST_CHECK_EQUAL(parsed2.str(), "file:/dev/sda "
+		      "path:/devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda "
+		      "name:sda majorminor:8:0 device-type:disk by-path-links:<pci-0000:00:1f.2-ata-1> "
+		      "by-id-links:<wwn-0x50014ee203733bb5>\n");
+}
+
+
+BOOST_AUTO_TEST_CASE(settle_once)
+{
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+
+    UdevadmSettle::Epoch epoch;
+
+    UdevadmSettle::settle();
+    UdevadmSettle::settle();
+
+    BOOST_CHECK_EQUAL(UdevadmSettle::get_count(), 1);
+
+    // parted triggers udev events
+
+    vector<string> input = {
+	"BYT;",
+	"/dev/sda:16777216s:scsi:512:512:msdos:ATA VBOX HARDDISK:;"
+    };
+
+    Mockup::set_command(PARTEDBIN " --script --machine '/dev/sda' unit s print", input);
+
+    Parted parted("/dev/sda");
+
+    UdevadmSettle::settle();
+    UdevadmSettle::settle();
+
+    BOOST_CHECK_EQUAL(UdevadmSettle::get_count(), 2);
+}
+
+
+BOOST_AUTO_TEST_CASE(settle_always_outside_epoch)
+{
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+
+    {
+	UdevadmSettle::Epoch epoch;
+
+	UdevadmSettle::settle();
+    }
+
+    UdevadmSettle::settle();
+    UdevadmSettle::settle();
+
+    BOOST_CHECK_EQUAL(UdevadmSettle::get_count(), 3);
+}
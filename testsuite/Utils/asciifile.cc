@@ -0,0 +1,162 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "storage/Utils/AsciiFile.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+vector<string>
+read_lines(const string& filename)
+{
+    vector<string> lines;
+
+    ifstream s(filename);
+    string line;
+    while (getline(s, line))
+	lines.push_back(line);
+
+    return lines;
+}
+
+
+BOOST_AUTO_TEST_CASE(save)
+{
+    unlink("asciifile.txt");
+
+    {
+	ofstream s("asciifile.txt");
+	s << "old\n";
+    }
+
+    struct stat st1;
+    BOOST_REQUIRE(stat("asciifile.txt", &st1) == 0);
+
+    AsciiFile ascii_file("asciifile.txt");
+    BOOST_CHECK_EQUAL(ascii_file.get_lines().size(), 1);
+
+    ascii_file.set_lines({ "first", "second" });
+    ascii_file.save();
+
+    BOOST_CHECK(read_lines("asciifile.txt") == vector<string>({ "first", "second" }));
+
+    // by default the file is written in place
+
+    struct stat st2;
+    BOOST_REQUIRE(stat("asciifile.txt", &st2) == 0);
+    BOOST_CHECK_EQUAL(st1.st_ino, st2.st_ino);
+
+    unlink("asciifile.txt");
+}
+
+
+BOOST_AUTO_TEST_CASE(save_replace)
+{
+    const string tmp_name = "asciifile.txt.tmp-" + to_string(getpid());
+
+    unlink("asciifile.txt");
+
+    {
+	ofstream s("asciifile.txt");
+	s << "old\n";
+    }
+
+    chmod("asciifile.txt", 0600);
+
+    // a stale temporary file does not prevent saving
+
+    {
+	ofstream s(tmp_name);
+	s << "stale stale stale\n";
+    }
+
+    struct stat st1;
+    BOOST_REQUIRE(stat("asciifile.txt", &st1) == 0);
+
+    AsciiFile ascii_file("asciifile.txt");
+    ascii_file.set_replace(true);
+
+    ascii_file.set_lines({ "first", "second" });
+    ascii_file.save();
+
+    BOOST_CHECK(read_lines("asciifile.txt") == vector<string>({ "first", "second" }));
+
+    // the file was replaced but the permissions are kept
+
+    struct stat st2;
+    BOOST_REQUIRE(stat("asciifile.txt", &st2) == 0);
+    BOOST_CHECK_NE(st1.st_ino, st2.st_ino);
+    BOOST_CHECK_EQUAL(st2.st_mode & 07777, 0600);
+
+    BOOST_CHECK(access(tmp_name.c_str(), F_OK) != 0);
+
+    unlink("asciifile.txt");
+}
+
+
+BOOST_AUTO_TEST_CASE(save_replace_hard_link)
+{
+    unlink("asciifile.txt");
+    unlink("asciifile-link.txt");
+
+    {
+	ofstream s("asciifile.txt");
+	s << "old\n";
+    }
+
+    BOOST_REQUIRE(link("asciifile.txt", "asciifile-link.txt") == 0);
+
+    AsciiFile ascii_file("asciifile-link.txt");
+    ascii_file.set_replace(true);
+
+    ascii_file.set_lines({ "new" });
+    ascii_file.save();
+
+    // the hard link is kept by writing the file in place
+
+    BOOST_CHECK(read_lines("asciifile.txt") == vector<string>({ "new" }));
+
+    unlink("asciifile.txt");
+    unlink("asciifile-link.txt");
+}
+
+
+BOOST_AUTO_TEST_CASE(save_symlink)
+{
+    unlink("asciifile.txt");
+    unlink("asciifile-link.txt");
+
+    {
+	ofstream s("asciifile.txt");
+	s << "old\n";
+    }
+
+    BOOST_REQUIRE(symlink("asciifile.txt", "asciifile-link.txt") == 0);
+
+    AsciiFile ascii_file("asciifile-link.txt");
+    ascii_file.set_replace(true);
+
+    ascii_file.set_lines({ "new" });
+    ascii_file.save();
+
+    // the symbolic link is kept and the file it points to is written
+
+    struct stat st;
+    BOOST_REQUIRE(lstat("asciifile-link.txt", &st) == 0);
+    BOOST_CHECK(S_ISLNK(st.st_mode));
+
+    BOOST_CHECK(read_lines("asciifile.txt") == vector<string>({ "new" }));
+
+    unlink("asciifile.txt");
+    unlink("asciifile-link.txt");
+}
@@ -0,0 +1,147 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <unistd.h>
+#include <stdio.h>
+#include <boost/test/unit_test.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "storage/Utils/LoggerImpl.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+vector<string>
+read_lines(const string& filename)
+{
+    vector<string> lines;
+
+    ifstream s(filename);
+    string line;
+    while (getline(s, line))
+	lines.push_back(line);
+
+    return lines;
+}
+
+
+BOOST_AUTO_TEST_CASE(logfile)
+{
+    unlink("logger.log");
+    unlink("logger.log.1");
+
+    set_logger(get_logfile_logger("logger.log"));
+
+    for (int i = 0; i < 1000; ++i)
+	y2mil("line " << i);
+
+    flush_logger();
+
+    vector<string> lines = read_lines("logger.log");
+    BOOST_REQUIRE_EQUAL(lines.size(), 1000);
+    BOOST_CHECK(boost::ends_with(lines[999], " line 999"));
+
+    // errors are written immediately
+
+    y2err("error");
+
+    lines = read_lines("logger.log");
+    BOOST_REQUIRE_EQUAL(lines.size(), 1001);
+    BOOST_CHECK(boost::ends_with(lines[1000], " error"));
+
+    // rotated log file
+
+    rename("logger.log", "logger.log.1");
+
+    y2mil("after rotation");
+
+    flush_logger();
+
+    BOOST_CHECK_EQUAL(read_lines("logger.log.1").size(), 1001);
+
+    lines = read_lines("logger.log");
+    BOOST_REQUIRE_EQUAL(lines.size(), 1);
+    BOOST_CHECK(boost::ends_with(lines[0], " after rotation"));
+
+    set_logger(nullptr);
+
+    unlink("logger.log");
+    unlink("logger.log.1");
+}
+
+
+class CountingLogger : public Logger
+{
+public:
+
+    virtual bool test(LogLevel log_level, const std::string& component) override
+    {
+	++tests;
+	return log_level != LogLevel::DEBUG;
+    }
+
+    virtual void write(LogLevel log_level, const std::string& component, const std::string& file,
+		       int line, const std::string& function, const std::string& content) override
+    {
+	lines.push_back(content);
+    }
+
+    int tests = 0;
+    vector<string> lines;
+
+};
+
+
+struct Nested
+{
+};
+
+
+std::ostream&
+operator<<(std::ostream& s, const Nested& nested)
+{
+    y2mil("nested");
+
+    return s << "outer";
+}
+
+
+BOOST_AUTO_TEST_CASE(custom_test)
+{
+    CountingLogger logger;
+    set_logger(&logger);
+
+    for (int i = 0; i < 100; ++i)
+    {
+	y2deb("debug " << i);
+	y2mil("milestone " << std::hex << i);
+    }
+
+    // The result of Logger::test of custom loggers is not cached since it
+    // may change at any time
+
+    BOOST_CHECK_EQUAL(logger.tests, 200);
+
+    BOOST_REQUIRE_EQUAL(logger.lines.size(), 100);
+    BOOST_CHECK_EQUAL(logger.lines[99], "milestone 0x63");
+
+    // formatting is reset for every message
+
+    y2mil(10);
+    BOOST_CHECK_EQUAL(logger.lines.back(), "10");
+
+    // logging while formatting a message
+
+    y2mil("message " << Nested());
+    BOOST_REQUIRE_EQUAL(logger.lines.size(), 103);
+    BOOST_CHECK_EQUAL(logger.lines[101], "nested");
+    BOOST_CHECK_EQUAL(logger.lines[102], "message outer");
+
+    set_logger(nullptr);
+}
@@ -0,0 +1,152 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <unistd.h>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Utils/ProbeCache.h"
+#include "storage/Utils/Mockup.h"
+#include "storage/Utils/StorageDefines.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+static void
+set_command(const string& name, const ProbeCache::Command& command)
+{
+    ProbeCache::set_command(name, ProbeCache::get_key(name), command);
+}
+
+
+BOOST_AUTO_TEST_CASE(save_and_load)
+{
+    const string filename = "probe-cache.xml";
+
+    unlink(filename.c_str());
+
+    // saving runs 'udevadm settle'
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+
+    ProbeCache::load(filename);
+    BOOST_CHECK(ProbeCache::is_active());
+
+    set_command("/usr/sbin/parted --script '/dev/does-not-exist' unit s print",
+		ProbeCache::Command({ "hello" }));
+    set_command("/usr/sbin/parted --script '/dev/failed' unit s print",
+		ProbeCache::Command({}, { "error" }, 1));
+    set_command(UDEVADMBIN_SETTLE, ProbeCache::Command());
+
+    ProbeCache::save(filename);
+    BOOST_CHECK(!ProbeCache::is_active());
+
+    ProbeCache::load(filename);
+
+    const ProbeCache::Command* command =
+	ProbeCache::find_command("/usr/sbin/parted --script '/dev/does-not-exist' unit s print");
+    BOOST_REQUIRE(command);
+    BOOST_CHECK_EQUAL(command->stdout.size(), 1u);
+    BOOST_CHECK_EQUAL(command->stdout[0], "hello");
+
+    BOOST_CHECK(!ProbeCache::find_command("/usr/sbin/parted --script '/dev/failed' unit s print"));
+    BOOST_CHECK(!ProbeCache::find_command(UDEVADMBIN_SETTLE));
+
+    ProbeCache::clear();
+    BOOST_CHECK(!ProbeCache::is_active());
+
+    unlink(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(not_cacheable)
+{
+    ProbeCache::load("does-not-exist.xml");
+
+    // The output of commands working on mount points changes without any
+    // uevent.
+
+    set_command("/usr/bin/df --block-size=1 --output=size,used,avail,fstype '/mnt'",
+		ProbeCache::Command({ "hello" }));
+    set_command("/usr/sbin/btrfs subvolume list -a -p '/mnt'",
+		ProbeCache::Command({ "hello" }));
+
+    BOOST_CHECK(!ProbeCache::find_command("/usr/bin/df --block-size=1 --output=size,used,avail,fstype '/mnt'"));
+    BOOST_CHECK(!ProbeCache::find_command("/usr/sbin/btrfs subvolume list -a -p '/mnt'"));
+
+    // Commands on devices, on directories in /dev and without paths are
+    // cached.
+
+    set_command("/sbin/blkid -c '/dev/null'", ProbeCache::Command({ "hello" }));
+    set_command("/usr/bin/ls -1l --sort=none '/dev/disk/by-id'", ProbeCache::Command({ "hello" }));
+
+    BOOST_CHECK(ProbeCache::find_command("/sbin/blkid -c '/dev/null'"));
+    BOOST_CHECK(ProbeCache::find_command("/usr/bin/ls -1l --sort=none '/dev/disk/by-id'"));
+
+    ProbeCache::clear();
+}
+
+
+BOOST_AUTO_TEST_CASE(key_pending)
+{
+    const string filename = "probe-cache-pending.xml";
+
+    unlink(filename.c_str());
+
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+
+    ProbeCache::load(filename);
+
+    // Commands causing uevents get their key when saving.
+
+    ProbeCache::set_command_key_pending("/usr/sbin/parted --script '/dev/does-not-exist' unit s print",
+					ProbeCache::Command({ "hello" }));
+    ProbeCache::set_command_key_pending("/usr/sbin/parted --script '/dev/failed' unit s print",
+					ProbeCache::Command({}, { "error" }, 1));
+
+    ProbeCache::save(filename);
+
+    ProbeCache::load(filename);
+
+    BOOST_CHECK(ProbeCache::find_command("/usr/sbin/parted --script '/dev/does-not-exist' unit s print"));
+    BOOST_CHECK(!ProbeCache::find_command("/usr/sbin/parted --script '/dev/failed' unit s print"));
+
+    ProbeCache::clear();
+
+    Mockup::set_mode(Mockup::Mode::NONE);
+
+    unlink(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(changed_while_probing)
+{
+    const string filename = "probe-cache-changed.xml";
+
+    unlink(filename.c_str());
+
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command(UDEVADMBIN_SETTLE, {});
+
+    ProbeCache::load(filename);
+
+    // The key computed when the command was run does not match the key
+    // when saving, so the output may be outdated.
+
+    ProbeCache::set_command("/sbin/blkid -c '/dev/null'", "outdated", ProbeCache::Command({ "hello" }));
+
+    ProbeCache::save(filename);
+
+    ProbeCache::load(filename);
+
+    BOOST_CHECK(!ProbeCache::find_command("/sbin/blkid -c '/dev/null'"));
+
+    ProbeCache::clear();
+
+    Mockup::set_mode(Mockup::Mode::NONE);
+
+    unlink(filename.c_str());
+}
@@ -0,0 +1,124 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include "storage/Utils/Exception.h"
+#include "storage/Utils/Mockup.h"
+#include "storage/Utils/Stopwatch.h"
+#include "storage/Utils/SystemCmdGroup.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    vector<string> finished;
+
+    SystemCmdGroup group;
+
+    Stopwatch stopwatch;
+
+    const SystemCmd& cmd1 = group.start(SystemCmd::Options("sleep 1 ; echo one"),
+					[&finished](const SystemCmd& cmd) { finished.push_back(cmd.stdout()[0]); });
+    const SystemCmd& cmd2 = group.start(SystemCmd::Options("sleep 1 ; echo two"),
+					[&finished](const SystemCmd& cmd) { finished.push_back(cmd.stdout()[0]); });
+    const SystemCmd& cmd3 = group.start(SystemCmd::Options("../helpers/retcode 42"));
+
+    group.wait();
+
+    // the commands run concurrently
+    BOOST_CHECK_LT(stopwatch.read(), 1.8);
+
+    BOOST_CHECK_EQUAL(group.num_running(), 0);
+    BOOST_CHECK_EQUAL(finished.size(), 2);
+
+    BOOST_CHECK_EQUAL(cmd1.retcode(), 0);
+    BOOST_CHECK_EQUAL(cmd1.stdout().size(), 1);
+    BOOST_CHECK_EQUAL(cmd1.stdout()[0], "one");
+
+    BOOST_CHECK_EQUAL(cmd2.retcode(), 0);
+    BOOST_CHECK_EQUAL(cmd2.stdout().size(), 1);
+    BOOST_CHECK_EQUAL(cmd2.stdout()[0], "two");
+
+    BOOST_CHECK_EQUAL(cmd3.retcode(), 42);
+}
+
+
+BOOST_AUTO_TEST_CASE(max_running)
+{
+    SystemCmdGroup group;
+
+    const SystemCmd& cmd1 = group.start(SystemCmd::Options("echo one"));
+    group.start(SystemCmd::Options("sleep 1"));
+
+    group.wait(1);
+
+    BOOST_CHECK_EQUAL(group.num_running(), 1);
+    BOOST_CHECK_EQUAL(cmd1.stdout().size(), 1);
+
+    group.wait();
+
+    BOOST_CHECK_EQUAL(group.num_running(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(pipe_stdin)
+{
+    SystemCmd::Options options("cat");
+    options.stdin_text = "Hello, cruel world\nI'm leaving you today";
+
+    SystemCmdGroup group;
+
+    const SystemCmd& cmd = group.start(options);
+
+    group.wait();
+
+    BOOST_CHECK_EQUAL(cmd.stdout().size(), 2);
+    BOOST_CHECK_EQUAL(cmd.stdout()[1], "I'm leaving you today");
+}
+
+
+BOOST_AUTO_TEST_CASE(do_throw)
+{
+    SystemCmdGroup group;
+
+    group.start(SystemCmd::Options("../helpers/retcode 42", SystemCmd::DoThrow));
+
+    BOOST_CHECK_THROW(group.wait(), Exception);
+}
+
+
+BOOST_AUTO_TEST_CASE(mockup)
+{
+    Mockup::set_mode(Mockup::Mode::RECORD);
+
+    {
+	SystemCmdGroup group;
+	group.start(SystemCmd::Options("echo hello"));
+	group.wait();
+    }
+
+    BOOST_REQUIRE(Mockup::has_command("echo hello"));
+    BOOST_CHECK_EQUAL(Mockup::get_command("echo hello").stdout.size(), 1);
+    BOOST_CHECK_EQUAL(Mockup::get_command("echo hello").stdout[0], "hello");
+
+    Mockup::set_mode(Mockup::Mode::PLAYBACK);
+    Mockup::set_command("echo world", RemoteCommand({ "mockup" }));
+
+    {
+	SystemCmdGroup group;
+	const SystemCmd& cmd = group.start(SystemCmd::Options("echo world"));
+	group.wait();
+
+	BOOST_CHECK_EQUAL(cmd.stdout().size(), 1);
+	BOOST_CHECK_EQUAL(cmd.stdout()[0], "mockup");
+    }
+
+    Mockup::set_mode(Mockup::Mode::NONE);
+}
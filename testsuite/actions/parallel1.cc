@@ -0,0 +1,22 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Utils/Logger.h"
+#include "testsuite/helpers/TsCmp.h"
+
+
+using namespace storage;
+
+
+// Check that independent actions on different disks can be committed in
+// parallel.
+
+BOOST_AUTO_TEST_CASE(actions)
+{
+    set_logger(get_stdout_logger());
+
+    TsCmpActiongraph cmp("parallel1", true, 4);
+    BOOST_CHECK_MESSAGE(cmp.ok(), cmp);
+}
@@ -0,0 +1,47 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <set>
+
+#include "storage/Utils/Logger.h"
+#include "testsuite/helpers/TsCmp.h"
+
+
+using namespace storage;
+
+
+class ThreadLogger : public Logger
+{
+public:
+
+    virtual void write(LogLevel log_level, const std::string& component, const std::string& file,
+		       int line, const std::string& function, const std::string& content) override
+    {
+	thread_ids.insert(std::this_thread::get_id());
+    }
+
+    std::set<std::thread::id> thread_ids;
+
+};
+
+
+// Check that with a custom logger, e.g. one implemented in the bindings,
+// the actions are committed one after another from the calling thread.
+
+BOOST_AUTO_TEST_CASE(actions)
+{
+    ThreadLogger thread_logger;
+    set_logger(&thread_logger);
+
+    TsCmpActiongraph cmp("parallel1", true, 4);
+
+    set_logger(nullptr);
+
+    BOOST_CHECK_MESSAGE(cmp.ok(), cmp);
+
+    BOOST_CHECK_EQUAL(thread_logger.thread_ids.size(), 1);
+    BOOST_CHECK_EQUAL(thread_logger.thread_ids.count(std::this_thread::get_id()), 1);
+}
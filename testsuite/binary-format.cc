@@ -0,0 +1,104 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <fstream>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Environment.h"
+#include "storage/Storage.h"
+#include "storage/Devicegraph.h"
+#include "storage/Utils/Exception.h"
+#include "storage/Utils/BinaryFile.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+vector<string>
+read_lines(const string& filename)
+{
+    vector<string> lines;
+
+    ifstream file(filename);
+    string line;
+    while (getline(file, line))
+    {
+	// skip comment with hostname and time
+	if (line.find("generated by libstorage-ng") == string::npos)
+	    lines.push_back(line);
+    }
+
+    return lines;
+}
+
+
+void
+check_round_trip(const string& filename)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* xml = storage.create_devicegraph("xml");
+    xml->load(filename);
+    xml->save("binary-format.xml");
+    xml->save("binary-format.bin", DevicegraphFormat::BINARY);
+
+    Devicegraph* binary = storage.create_devicegraph("binary");
+    binary->load("binary-format.bin");
+    binary->save("binary-format-converted.xml");
+
+    BOOST_CHECK_EQUAL(binary->num_devices(), xml->num_devices());
+    BOOST_CHECK_EQUAL(binary->num_holders(), xml->num_holders());
+    BOOST_CHECK(*binary == *xml);
+
+    vector<string> lhs = read_lines("binary-format.xml");
+    vector<string> rhs = read_lines("binary-format-converted.xml");
+    BOOST_CHECK_EQUAL_COLLECTIONS(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    check_round_trip("probe/lvm1-devicegraph.xml");
+    check_round_trip("probe/btrfs1-devicegraph.xml");
+    check_round_trip("probe/md3-devicegraph.xml");
+}
+
+
+BOOST_AUTO_TEST_CASE(wrong_file)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    ofstream("binary-format-corrupt.bin") << "LSNGDG\r\n" << "corrupt";
+
+    Devicegraph* devicegraph = storage.create_devicegraph("corrupt");
+    BOOST_CHECK_THROW(devicegraph->load("binary-format-corrupt.bin"), Exception);
+}
+
+
+BOOST_AUTO_TEST_CASE(deep_nesting)
+{
+    // A device with nodes nested deeper than allowed is rejected
+    // instead of exhausting the stack.
+
+    xmlNode* root = xmlNewNode(NULL, (const xmlChar*) "Disk");
+
+    xmlNode* node = root;
+    for (unsigned int i = 0; i < BinaryFormat::max_depth; ++i)
+	node = xmlNewChild(node, NULL, (const xmlChar*) "Nested", NULL);
+
+    BinaryFileWriter writer;
+    writer.add_device(root);
+    BOOST_REQUIRE(writer.save_to_file("binary-format-deep.bin"));
+
+    xmlFreeNode(root);
+
+    BinaryFile binary_file("binary-format-deep.bin");
+    BOOST_REQUIRE_EQUAL(binary_file.num_devices(), 1);
+    BOOST_CHECK_THROW(binary_file.get_device_node(0), Exception);
+}
@@ -0,0 +1,89 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Devices/Disk.h"
+#include "storage/Devices/Gpt.h"
+#include "storage/Devices/Partition.h"
+#include "storage/Holders/User.h"
+#include "storage/Environment.h"
+#include "storage/Storage.h"
+#include "storage/Devicegraph.h"
+#include "storage/DevicegraphImpl.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+BOOST_AUTO_TEST_CASE(generation)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* staging = storage.get_staging();
+
+    unsigned long generation1 = staging->get_impl().get_generation();
+
+    Disk* sda = Disk::create(staging, "/dev/sda");
+    PartitionTable* gpt = sda->create_partition_table(PtType::GPT);
+
+    unsigned long generation2 = staging->get_impl().get_generation();
+    BOOST_CHECK_NE(generation1, generation2);
+
+    BOOST_CHECK_NO_THROW(storage.check());
+
+    // checking does not change the generation
+
+    BOOST_CHECK_EQUAL(staging->get_impl().get_generation(), generation2);
+
+    // copies have a different generation
+
+    Devicegraph* copy = storage.copy_devicegraph("staging", "copy");
+    BOOST_CHECK_NE(copy->get_impl().get_generation(), generation2);
+
+    BOOST_CHECK_NO_THROW(storage.check());
+
+    // a modification after a successful check must be checked again
+
+    User::create(staging, gpt, sda);
+
+    BOOST_CHECK_NE(staging->get_impl().get_generation(), generation2);
+
+    BOOST_CHECK_THROW(storage.check(), Exception);
+    BOOST_CHECK_THROW(staging->check(), Exception);
+
+    // an unmodified devicegraph is still fine
+
+    BOOST_CHECK_NO_THROW(copy->check());
+}
+
+
+BOOST_AUTO_TEST_CASE(incremental)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* staging = storage.get_staging();
+
+    Disk* sda = Disk::create(staging, "/dev/sda");
+    PartitionTable* gpt = sda->create_partition_table(PtType::GPT);
+    Partition* sda1 = gpt->create_partition("/dev/sda1", Region(2048, 1000, 512), PartitionType::PRIMARY);
+
+    BOOST_CHECK_NO_THROW(staging->check());
+
+    // only the new device is checked again
+
+    Disk::create(staging, "/dev/sdb");
+
+    BOOST_CHECK_NO_THROW(staging->check());
+
+    // a new holder closing a longer cycle is found
+
+    User::create(staging, sda1, sda);
+
+    BOOST_CHECK_THROW(staging->check(), Exception);
+}
@@ -348,3 +348,208 @@ BOOST_AUTO_TEST_CASE( diff_with_context )
     BOOST_CHECK( check_diff( input03, input01, expected_03_01, context ) );
     BOOST_CHECK( check_diff( {},      input01, expected_00_01, context ) );
 }
+
+
+/**
+ * The hunks as (removed start, removed count, added start, added count).
+ **/
+typedef std::vector<std::vector<int>> hunk_vec;
+
+
+/**
+ * The former diff algorithm: recursively split at the longest common run of
+ * lines. Used as reference for the randomized tests.
+ **/
+void
+reference_diff( const string_vec & a, int a_start, int a_end,
+		const string_vec & b, int b_start, int b_end,
+		hunk_vec & hunks )
+{
+    while ( a_start <= a_end && b_start <= b_end && a[ a_start ] == b[ b_start ] )
+    {
+	++a_start;
+	++b_start;
+    }
+
+    while ( a_end > a_start && b_end > b_start && a[ a_end ] == b[ b_end ] )
+    {
+	--a_end;
+	--b_end;
+    }
+
+    if ( a_start > a_end && b_start > b_end )
+	return;
+
+    int best_len = 0;
+    int best_a = -1;
+    int best_b = -1;
+
+    for ( int i = a_start; i <= a_end; ++i )
+    {
+	for ( int j = b_start; j <= b_end; ++j )
+	{
+	    int len = 0;
+
+	    while ( i + len <= a_end && j + len <= b_end && a[ i + len ] == b[ j + len ] )
+		++len;
+
+	    if ( len > best_len )
+	    {
+		best_len = len;
+		best_a = i;
+		best_b = j;
+	    }
+	}
+    }
+
+    if ( best_len > 0 )
+    {
+	reference_diff( a, a_start, best_a - 1, b, b_start, best_b - 1, hunks );
+	reference_diff( a, best_a + best_len, a_end, b, best_b + best_len, b_end, hunks );
+    }
+    else
+    {
+	hunks.push_back( { a_start, a_end - a_start + 1, b_start, b_end - b_start + 1 } );
+    }
+}
+
+
+hunk_vec
+reference_hunks( const string_vec & a, const string_vec & b )
+{
+    hunk_vec hunks;
+    reference_diff( a, 0, a.size() - 1, b, 0, b.size() - 1, hunks );
+    return hunks;
+}
+
+
+hunk_vec
+myers_hunks( const string_vec & a, const string_vec & b )
+{
+    hunk_vec hunks;
+
+    Diff diff( a, b, 0 );
+
+    for ( int i = 0; i < diff.get_hunk_count(); ++i )
+    {
+	const auto & hunk = diff.get_hunk( i );
+
+	hunks.push_back( { hunk.removed_start_pos, (int) hunk.lines_removed.size(),
+			   hunk.added_start_pos, (int) hunk.lines_added.size() } );
+    }
+
+    return hunks;
+}
+
+
+/**
+ * Apply the hunks to 'a'.
+ **/
+string_vec
+patch( const string_vec & a, const string_vec & b, const hunk_vec & hunks )
+{
+    string_vec result;
+    int pos_a = 0;
+
+    for ( const std::vector<int> & hunk : hunks )
+    {
+	result.insert( result.end(), a.begin() + pos_a, a.begin() + hunk[0] );
+	result.insert( result.end(), b.begin() + hunk[2], b.begin() + hunk[2] + hunk[3] );
+	pos_a = hunk[0] + hunk[1];
+    }
+
+    result.insert( result.end(), a.begin() + pos_a, a.end() );
+
+    return result;
+}
+
+
+int
+num_changed_lines( const hunk_vec & hunks )
+{
+    int num = 0;
+
+    for ( const std::vector<int> & hunk : hunks )
+	num += hunk[1] + hunk[3];
+
+    return num;
+}
+
+
+BOOST_AUTO_TEST_CASE( diff_random_unique_lines )
+{
+    // With unique lines and without moved lines the common lines are
+    // unambiguous. Then the hunks, and thus the output, must be the same as
+    // with the former algorithm.
+
+    srand( 42 );
+
+    for ( int n = 0; n < 500; ++n )
+    {
+	string_vec a;
+	string_vec b;
+
+	int size = rand() % 40;
+
+	for ( int i = 0; i < size; ++i )
+	    a.push_back( "line " + std::to_string( i ) );
+
+	for ( int i = 0; i < size; ++i )
+	{
+	    switch ( rand() % 6 )
+	    {
+		case 0:		// remove
+		    break;
+
+		case 1:		// insert before
+		    b.push_back( "new " + std::to_string( i ) );
+		    b.push_back( a[i] );
+		    break;
+
+		case 2:		// replace
+		    b.push_back( "changed " + std::to_string( i ) );
+		    break;
+
+		default:	// keep
+		    b.push_back( a[i] );
+		    break;
+	    }
+	}
+
+	if ( rand() % 4 == 0 )
+	    b.push_back( "new end" );
+
+	BOOST_CHECK( myers_hunks( a, b ) == reference_hunks( a, b ) );
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( diff_random_repeated_lines )
+{
+    // With repeated lines several diffs are possible. The hunks must
+    // transform a into b and must not be larger than with the former
+    // algorithm.
+
+    srand( 42 );
+
+    for ( int n = 0; n < 1000; ++n )
+    {
+	string_vec a;
+	string_vec b;
+
+	int size_a = rand() % 30;
+	int size_b = rand() % 30;
+
+	for ( int i = 0; i < size_a; ++i )
+	    a.push_back( string( 1, 'a' + rand() % 4 ) );
+
+	for ( int i = 0; i < size_b; ++i )
+	    b.push_back( string( 1, 'a' + rand() % 4 ) );
+
+	hunk_vec hunks = myers_hunks( a, b );
+
+	BOOST_CHECK( patch( a, b, hunks ) == b );
+
+	BOOST_CHECK_LE( num_changed_lines( hunks ), num_changed_lines( reference_hunks( a, b ) ) );
+    }
+}
@@ -58,3 +58,85 @@ BOOST_AUTO_TEST_CASE(copy)
 
     devicegraph_copy->check();
 }
+
+
+BOOST_AUTO_TEST_CASE(restore)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* staging = storage.get_staging();
+
+    Disk* sda = Disk::create(staging, "/dev/sda");
+    Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
+    gpt->create_partition("/dev/sda1", Region(2048, 1000, 512), PartitionType::PRIMARY);
+
+    storage.copy_devicegraph("staging", "backup");
+
+    gpt->create_partition("/dev/sda2", Region(4096, 1000, 512), PartitionType::PRIMARY);
+
+    BOOST_CHECK_EQUAL(staging->num_devices(), 4);
+
+    storage.restore_devicegraph("backup");
+
+    BOOST_CHECK(!storage.exist_devicegraph("backup"));
+
+    // The devices now in staging must refer to staging.
+
+    BOOST_CHECK_EQUAL(staging->num_devices(), 3);
+    BOOST_CHECK_EQUAL(staging->num_holders(), 2);
+
+    staging->check();
+
+    const Disk* restored_sda = Disk::find_by_name(staging, "/dev/sda");
+    BOOST_CHECK_EQUAL(restored_sda->get_devicegraph(), staging);
+    BOOST_CHECK_EQUAL(restored_sda->get_partition_table()->get_partitions().size(), 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(copy_on_write)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* staging = storage.get_staging();
+
+    Disk* sda = Disk::create(staging, "/dev/sda");
+    Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
+    Partition* sda1 = gpt->create_partition("/dev/sda1", Region(2048, 1000, 512), PartitionType::PRIMARY);
+
+    Devicegraph* copy1 = storage.copy_devicegraph("staging", "copy1");
+    Devicegraph* copy2 = storage.copy_devicegraph("copy1", "copy2");
+
+    BOOST_CHECK(*staging == *copy1);
+    BOOST_CHECK(*staging == *copy2);
+
+    // Modifying a device in one devicegraph must not modify the devices
+    // in the other devicegraphs.
+
+    Partition* copy1_sda1 = Partition::find_by_name(copy1, "/dev/sda1");
+    BOOST_CHECK_EQUAL(copy1_sda1->get_devicegraph(), copy1);
+    copy1_sda1->set_region(Region(2048, 2000, 512));
+
+    sda1->set_region(Region(2048, 3000, 512));
+
+    BOOST_CHECK_EQUAL(sda1->get_region().get_length(), 3000);
+    BOOST_CHECK_EQUAL(copy1_sda1->get_region().get_length(), 2000);
+    BOOST_CHECK_EQUAL(Partition::find_by_name(copy2, "/dev/sda1")->get_region().get_length(), 1000);
+
+    // Navigation from a copied device must stay in its devicegraph.
+
+    const Partition* copy2_sda1 = Partition::find_by_name(copy2, "/dev/sda1");
+    BOOST_CHECK_EQUAL(copy2_sda1->get_devicegraph(), copy2);
+    BOOST_CHECK_EQUAL(copy2_sda1->get_partition_table()->get_devicegraph(), copy2);
+    BOOST_CHECK_EQUAL(to_disk(copy2_sda1->get_partitionable())->get_devicegraph(), copy2);
+
+    storage.remove_devicegraph("copy1");
+
+    BOOST_CHECK_EQUAL(Disk::find_by_name(copy2, "/dev/sda")->get_devicegraph(), copy2);
+
+    staging->check();
+    copy2->check();
+}
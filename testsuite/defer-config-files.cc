@@ -0,0 +1,117 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Devices/Disk.h"
+#include "storage/Devices/Gpt.h"
+#include "storage/Devices/Partition.h"
+#include "storage/Devices/Encryption.h"
+#include "storage/Filesystems/BlkFilesystem.h"
+#include "storage/Filesystems/MountPoint.h"
+#include "storage/Devicegraph.h"
+#include "storage/Storage.h"
+#include "storage/Environment.h"
+#include "storage/CommitOptions.h"
+#include "storage/Utils/AsciiFile.h"
+#include "storage/Utils/Region.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+namespace
+{
+
+    /**
+     * Commits the addition of two mount points and one encryption
+     * layer device to /etc/fstab and /etc/crypttab below a
+     * temporary rootprefix and returns the resulting files.
+     */
+    pair<vector<string>, vector<string>>
+    commit(bool defer_config_files)
+    {
+	char tmp[] = "defer-config-files-XXXXXX";
+	BOOST_REQUIRE(mkdtemp(tmp));
+
+	const string rootprefix = string(tmp);
+	BOOST_REQUIRE(mkdir((rootprefix + "/etc").c_str(), 0755) == 0);
+
+	AsciiFile(rootprefix + "/etc/fstab").save();
+	AsciiFile(rootprefix + "/etc/crypttab").save();
+
+	Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+	Storage storage(environment);
+	storage.set_rootprefix(rootprefix);
+
+	Devicegraph* system = storage.get_system();
+
+	Disk* sda = Disk::create(system, "/dev/sda", Region(0, 1000000, 512));
+	Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
+
+	Partition* sda1 = gpt->create_partition("/dev/sda1", Region(2048, 100000, 512),
+						 PartitionType::PRIMARY);
+	sda1->create_blk_filesystem(FsType::EXT4);
+
+	Partition* sda2 = gpt->create_partition("/dev/sda2", Region(102048, 100000, 512),
+						 PartitionType::PRIMARY);
+	Encryption* encryption = sda2->create_encryption("cr-test");
+	encryption->set_mount_by(MountByType::DEVICE);
+	encryption->set_in_etc_crypttab(false);
+	encryption->create_blk_filesystem(FsType::XFS);
+
+	system->copy(*storage.get_staging());
+
+	Devicegraph* staging = storage.get_staging();
+
+	Partition* staging_sda1 = Partition::find_by_name(staging, "/dev/sda1");
+	MountPoint* mount_point1 = staging_sda1->get_blk_filesystem()->create_mount_point("/test1");
+	mount_point1->set_mount_by(MountByType::DEVICE);
+	mount_point1->set_active(false);
+
+	Encryption* staging_encryption = to_encryption(BlkDevice::find_by_name(staging, "/dev/mapper/cr-test"));
+	staging_encryption->set_in_etc_crypttab(true);
+	MountPoint* mount_point2 = staging_encryption->get_blk_filesystem()->create_mount_point("/test2");
+	mount_point2->set_mount_by(MountByType::DEVICE);
+	mount_point2->set_active(false);
+
+	storage.calculate_actiongraph();
+	storage.commit(CommitOptions(false, 1, defer_config_files));
+
+	pair<vector<string>, vector<string>> ret =
+	    make_pair(AsciiFile(rootprefix + "/etc/fstab").get_lines(),
+		      AsciiFile(rootprefix + "/etc/crypttab").get_lines());
+
+	unlink((rootprefix + "/etc/fstab").c_str());
+	unlink((rootprefix + "/etc/crypttab").c_str());
+	rmdir((rootprefix + "/etc").c_str());
+	rmdir(rootprefix.c_str());
+
+	return ret;
+    }
+
+}
+
+
+BOOST_AUTO_TEST_CASE(same_files)
+{
+    set_logger(get_stdout_logger());
+
+    const pair<vector<string>, vector<string>> immediate = commit(false);
+
+    BOOST_CHECK_EQUAL(immediate.first.size(), 2);
+    BOOST_CHECK_EQUAL(immediate.second.size(), 1);
+
+    const pair<vector<string>, vector<string>> deferred = commit(true);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(deferred.first.begin(), deferred.first.end(),
+				  immediate.first.begin(), immediate.first.end());
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(deferred.second.begin(), deferred.second.end(),
+				  immediate.second.begin(), immediate.second.end());
+}
@@ -110,3 +110,34 @@ BOOST_AUTO_TEST_CASE(remove1)
         "ARRAY /dev/md1 UUID=0a1750eb:b5efbc17:b0bb6de2:b707a04f"
     });
 }
+
+
+BOOST_AUTO_TEST_CASE(deferred1)
+{
+    setup({
+        "DEVICE containers partitions",
+        "ARRAY /dev/md0 UUID=0a278ebc:9aea4c40:554a5f39:b52224a7"
+    });
+
+    EtcMdadm etc_mdadm;
+    etc_mdadm.set_auto_save(false);
+
+    EtcMdadm::Entry entry;
+    entry.device = "/dev/md1";
+    entry.uuid = "0a1750eb:b5efbc17:b0bb6de2:b707a04f";
+
+    etc_mdadm.update_entry(entry);
+    etc_mdadm.remove_entry("0a278ebc:9aea4c40:554a5f39:b52224a7");
+
+    check({
+        "DEVICE containers partitions",
+        "ARRAY /dev/md0 UUID=0a278ebc:9aea4c40:554a5f39:b52224a7"
+    });
+
+    etc_mdadm.write();
+
+    check({
+        "DEVICE containers partitions",
+        "ARRAY /dev/md1 UUID=0a1750eb:b5efbc17:b0bb6de2:b707a04f"
+    });
+}
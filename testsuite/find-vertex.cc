@@ -7,6 +7,7 @@
 #include "storage/Devices/DiskImpl.h"
 #include "storage/Devices/Gpt.h"
 #include "storage/Devices/PartitionImpl.h"
+#include "storage/Devices/LvmVgImpl.h"
 #include "storage/Holders/Subdevice.h"
 #include "storage/Environment.h"
 #include "storage/Storage.h"
@@ -32,6 +33,7 @@ BOOST_AUTO_TEST_CASE(find_vertex)
     Disk* sda = Disk::create(devicegraph, "/dev/sda");
     sda->get_impl().set_sysfs_path("/devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda");
     sda->get_impl().set_sysfs_name("sda");
+    sda->get_impl().set_udev_ids({ "ata-VBOX_HARDDISK_VB3b96ac9d-f9f14bd2" });
 
     Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
 
@@ -68,6 +70,11 @@ BOOST_AUTO_TEST_CASE(find_vertex)
 
     BOOST_CHECK_EQUAL(BlkDevice::find_by_any_name(system, "/dev/sda1")->get_sid(), sda1->get_sid());
 
+    // Neither does looking up a device by an udev link libstorage-ng knows.
+
+    BOOST_CHECK_EQUAL(BlkDevice::find_by_any_name(system, "/dev/disk/by-id/ata-VBOX_HARDDISK_VB3b96ac9d-f9f14bd2")->get_sid(),
+		      sda->get_sid());
+
     // Looking up a device by another name needs udevadm info calls.
 
     Mockup::set_command(UDEVADMBIN " info '/dev/block/8:1'", vector<string>({
@@ -91,3 +98,152 @@ BOOST_AUTO_TEST_CASE(find_vertex)
 
     BOOST_CHECK_THROW(BlkDevice::find_by_any_name(system, "/dev/does-not-exist"), DeviceNotFound);
 }
+
+
+BOOST_AUTO_TEST_CASE(find_vertex_and_edge_after_modifications)
+{
+    set_logger(get_stdout_logger());
+
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* devicegraph = storage.get_staging();
+
+    Disk* sda = Disk::create(devicegraph, "/dev/sda");
+    Disk* sdb = Disk::create(devicegraph, "/dev/sdb");
+
+    Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
+
+    Partition* sda1 = gpt->create_partition("/dev/sda1", Region(2048, 1000000, 512), PartitionType::PRIMARY);
+
+    BOOST_CHECK(devicegraph->holder_exists(sda->get_sid(), gpt->get_sid()));
+    BOOST_CHECK(devicegraph->holder_exists(gpt->get_sid(), sda1->get_sid()));
+    BOOST_CHECK(!devicegraph->holder_exists(sdb->get_sid(), gpt->get_sid()));
+
+    // Moving the partition table from sda to sdb must update the edge index.
+
+    Devicegraph::Impl& impl = devicegraph->get_impl();
+
+    Devicegraph::Impl::edge_descriptor edge = impl.find_edge(sda->get_sid(), gpt->get_sid());
+    impl.set_source(edge, sdb->get_impl().get_vertex());
+
+    BOOST_CHECK(!devicegraph->holder_exists(sda->get_sid(), gpt->get_sid()));
+    BOOST_CHECK(devicegraph->holder_exists(sdb->get_sid(), gpt->get_sid()));
+    BOOST_CHECK_THROW(devicegraph->find_holder(sda->get_sid(), gpt->get_sid()), HolderNotFoundBySids);
+
+    devicegraph->check();
+
+    // The copy must have its own indices.
+
+    Devicegraph* copy = storage.copy_devicegraph("staging", "copy");
+
+    BOOST_CHECK_EQUAL(copy->find_device(sda1->get_sid())->get_sid(), sda1->get_sid());
+    BOOST_CHECK(copy->find_device(sda1->get_sid()) != sda1);
+    BOOST_CHECK(copy->holder_exists(sdb->get_sid(), gpt->get_sid()));
+
+    copy->check();
+
+    // Removing a device must also remove its holders from the indices.
+
+    sid_t gpt_sid = gpt->get_sid();
+    sid_t sda1_sid = sda1->get_sid();
+
+    devicegraph->remove_device(sda1);
+    devicegraph->remove_device(gpt);
+
+    BOOST_CHECK(!devicegraph->device_exists(sda1_sid));
+    BOOST_CHECK(!devicegraph->device_exists(gpt_sid));
+    BOOST_CHECK(!devicegraph->holder_exists(sdb->get_sid(), gpt_sid));
+    BOOST_CHECK(!devicegraph->holder_exists(gpt_sid, sda1_sid));
+    BOOST_CHECK_THROW(devicegraph->find_device(gpt_sid), DeviceNotFoundBySid);
+
+    devicegraph->check();
+
+    // The copy is unaffected.
+
+    BOOST_CHECK(copy->device_exists(gpt_sid));
+    BOOST_CHECK(copy->holder_exists(gpt_sid, sda1_sid));
+
+    sid_t sdb_sid = sdb->get_sid();
+
+    devicegraph->clear();
+
+    BOOST_CHECK(!devicegraph->device_exists(sdb_sid));
+    BOOST_CHECK_EQUAL(devicegraph->num_devices(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(find_by_name_uuid_and_type_after_modifications)
+{
+    set_logger(get_stdout_logger());
+
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* devicegraph = storage.get_staging();
+
+    Disk* sda = Disk::create(devicegraph, "/dev/sda");
+    Disk* sdb = Disk::create(devicegraph, "/dev/sdb");
+
+    Gpt* gpt = to_gpt(sda->create_partition_table(PtType::GPT));
+
+    Partition* sda1 = gpt->create_partition("/dev/sda1", Region(2048, 1000000, 512), PartitionType::PRIMARY);
+
+    LvmVg* lvm_vg = LvmVg::create(devicegraph, "test");
+    lvm_vg->get_impl().set_uuid("Kc5Bf3-8QpN-yGcf-33ZW-Iy1J-9cJh-yw1cJp");
+
+    BOOST_CHECK_EQUAL(Disk::get_all(devicegraph).size(), 2);
+    BOOST_CHECK_EQUAL(Gpt::get_all(devicegraph).size(), 1);
+
+    // Renaming a device must update the name index.
+
+    sda1->get_impl().set_name("/dev/sda2");
+
+    BOOST_CHECK_THROW(BlkDevice::find_by_name(devicegraph, "/dev/sda1"), DeviceNotFound);
+    BOOST_CHECK_EQUAL(BlkDevice::find_by_name(devicegraph, "/dev/sda2"), sda1);
+
+    // The type is respected.
+
+    BOOST_CHECK_EQUAL(Partitionable::find_by_name(devicegraph, "/dev/sdb"), sdb);
+    BOOST_CHECK_THROW(Disk::find_by_name(devicegraph, "/dev/sda2"), DeviceHasWrongType);
+
+    // Changing the UUID must update the UUID index.
+
+    BOOST_CHECK_EQUAL(LvmVg::Impl::find_by_uuid(devicegraph, "Kc5Bf3-8QpN-yGcf-33ZW-Iy1J-9cJh-yw1cJp"), lvm_vg);
+
+    lvm_vg->get_impl().set_uuid("Vh6jvM-Jn1Y-3yTX-HyLl-p4Ed-Q7eZ-JW7RaR");
+
+    BOOST_CHECK_THROW(LvmVg::Impl::find_by_uuid(devicegraph, "Kc5Bf3-8QpN-yGcf-33ZW-Iy1J-9cJh-yw1cJp"),
+		      DeviceNotFound);
+    BOOST_CHECK_EQUAL(LvmVg::Impl::find_by_uuid(devicegraph, "Vh6jvM-Jn1Y-3yTX-HyLl-p4Ed-Q7eZ-JW7RaR"), lvm_vg);
+
+    devicegraph->check();
+
+    // The indices of a copy are independent.
+
+    Devicegraph* copy = storage.copy_devicegraph("staging", "copy");
+
+    BOOST_CHECK_EQUAL(BlkDevice::find_by_name(copy, "/dev/sda2")->get_sid(), sda1->get_sid());
+    BOOST_CHECK(BlkDevice::find_by_name(copy, "/dev/sda2") != sda1);
+
+    // Removing devices must update all indices.
+
+    sid_t sdb_sid = sdb->get_sid();
+
+    devicegraph->remove_device(sdb);
+    devicegraph->remove_device(lvm_vg);
+
+    BOOST_CHECK_EQUAL(Disk::get_all(devicegraph).size(), 1);
+    BOOST_CHECK_THROW(BlkDevice::find_by_name(devicegraph, "/dev/sdb"), DeviceNotFound);
+    BOOST_CHECK_THROW(LvmVg::Impl::find_by_uuid(devicegraph, "Vh6jvM-Jn1Y-3yTX-HyLl-p4Ed-Q7eZ-JW7RaR"),
+		      DeviceNotFound);
+
+    devicegraph->check();
+
+    BOOST_CHECK_EQUAL(Disk::get_all(copy).size(), 2);
+    BOOST_CHECK_EQUAL(BlkDevice::find_by_name(copy, "/dev/sdb")->get_sid(), sdb_sid);
+
+    copy->check();
+}
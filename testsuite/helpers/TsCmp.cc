@@ -193,7 +193,7 @@ namespace storage
     }
 
 
-    TsCmpActiongraph::TsCmpActiongraph(const string& name, bool commit)
+    TsCmpActiongraph::TsCmpActiongraph(const string& name, bool commit, unsigned int max_parallel_actions)
     {
 	Environment environment(true, ProbeMode::READ_DEVICEGRAPH, TargetMode::DIRECT);
 	environment.set_devicegraph_filename(name + "-probed.xml");
@@ -232,7 +232,7 @@ namespace storage
 	Mockup::set_mode(Mockup::Mode::PLAYBACK);
 	Mockup::load(name + "-mockup.xml");
 
-	CommitOptions commit_options(false);
+	CommitOptions commit_options(false, max_parallel_actions);
 
 	storage.calculate_actiongraph();
 	storage.commit(commit_options);
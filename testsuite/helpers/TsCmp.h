@@ -81,8 +81,10 @@ namespace storage
 	 * in the mockup file (otherwise an exception is raised). Due
 	 * to possible interaction of external programs and files this
 	 * is likely only useful for testing a few actions at once.
+	 *
+	 * max_parallel_actions is passed to the CommitOptions.
 	 */
-	TsCmpActiongraph(const string& name, bool commit = false);
+	TsCmpActiongraph(const string& name, bool commit = false, unsigned int max_parallel_actions = 1);
 
 	/**
 	 * Compares the actiongraph with the expected actiongraph.
@@ -0,0 +1,60 @@
+
+#include <sstream>
+
+#include "storage/Devices/Disk.h"
+#include "storage/Devices/PartitionTable.h"
+#include "storage/Devices/Partition.h"
+#include "storage/Filesystems/BlkFilesystem.h"
+#include "storage/Filesystems/MountPoint.h"
+#include "storage/Utils/Region.h"
+
+#include "testsuite/helpers/TsDisks.h"
+
+
+namespace storage
+{
+
+    string
+    disk_name(int i)
+    {
+	ostringstream s;
+	s << "/dev/disk" << i;
+	return s.str();
+    }
+
+
+    string
+    partition_name(int i, int j)
+    {
+	ostringstream s;
+	s << "/dev/disk" << i << "p" << j;
+	return s.str();
+    }
+
+
+    void
+    add_disk(Devicegraph* devicegraph, int i)
+    {
+	Disk::create(devicegraph, disk_name(i));
+    }
+
+
+    void
+    add_partitions(Devicegraph* devicegraph, int i)
+    {
+	Disk* disk = Disk::find_by_name(devicegraph, disk_name(i));
+
+	PartitionTable* partition_table = disk->create_partition_table(PtType::GPT);
+
+	for (int j = 1; j < 5; ++j)
+	{
+	    Partition* partition = partition_table->create_partition(partition_name(i, j),
+								     Region(1000 * j, 1000 * (j + 1), 512),
+								     PartitionType::PRIMARY);
+
+	    BlkFilesystem* blk_filesystem = partition->create_blk_filesystem(FsType::EXT4);
+	    blk_filesystem->create_mount_point("/data" + partition_name(i, j));
+	}
+    }
+
+}
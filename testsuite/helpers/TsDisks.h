@@ -0,0 +1,26 @@
+
+#include <string>
+
+#include "storage/Devicegraph.h"
+
+
+namespace storage
+{
+    using namespace std;
+
+
+    /**
+     * Functions to create many disks for the performance tests. Every
+     * disk has a partition table and four partitions each with a
+     * filesystem and a mount point, so 14 devices per disk.
+     */
+
+    string disk_name(int i);
+
+    string partition_name(int i, int j);
+
+    void add_disk(Devicegraph* devicegraph, int i);
+
+    void add_partitions(Devicegraph* devicegraph, int i);
+
+}
@@ -0,0 +1,53 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <iostream>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Devicegraph.h"
+#include "storage/DevicegraphImpl.h"
+#include "storage/Storage.h"
+#include "storage/Environment.h"
+#include "storage/Utils/Stopwatch.h"
+#include "testsuite/helpers/TsDisks.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+BOOST_AUTO_TEST_CASE(performance)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* devicegraph = storage.create_devicegraph("devicegraph");
+
+    // 1000 disks result in 14000 devices
+
+    const int n = 1000;
+
+    for (int i = 0; i < n; ++i)
+    {
+	add_disk(devicegraph, i);
+	add_partitions(devicegraph, i);
+    }
+
+    devicegraph->save("load1.xml");
+
+    Devicegraph* dom = storage.create_devicegraph("dom");
+
+    Stopwatch stopwatch_dom;
+    dom->get_impl().load_with_dom(dom, "load1.xml");
+    cout << "dom " << stopwatch_dom << endl;
+
+    Devicegraph* stream = storage.create_devicegraph("stream");
+
+    Stopwatch stopwatch_stream;
+    stream->load("load1.xml");
+    cout << "stream " << stopwatch_stream << endl;
+
+    BOOST_CHECK_EQUAL(stream->num_devices(), 14 * n);
+    BOOST_CHECK(*stream == *dom);
+}
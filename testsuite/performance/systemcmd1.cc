@@ -0,0 +1,48 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <iostream>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Utils/SystemCmd.h"
+#include "storage/Utils/Stopwatch.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+BOOST_AUTO_TEST_CASE(many_lines)
+{
+    // one million lines, about 7 MB
+
+    SystemCmd::Options options("/usr/bin/seq 1 1000000");
+    options.log_lines = false;
+
+    Stopwatch stopwatch;
+    SystemCmd cmd(options);
+    cout << "many lines " << stopwatch << endl;
+
+    BOOST_CHECK_EQUAL(cmd.retcode(), 0);
+    BOOST_REQUIRE_EQUAL(cmd.stdout().size(), 1000000);
+    BOOST_CHECK_EQUAL(cmd.stdout().front(), "1");
+    BOOST_CHECK_EQUAL(cmd.stdout().back(), "1000000");
+}
+
+
+BOOST_AUTO_TEST_CASE(long_line)
+{
+    // a single line of 8 MB without trailing newline
+
+    SystemCmd::Options options("/usr/bin/head -c 8388608 /dev/zero | /usr/bin/tr '\\0' 'x'");
+    options.log_lines = false;
+    options.log_line_limit = 0;
+
+    Stopwatch stopwatch;
+    SystemCmd cmd(options);
+    cout << "long line " << stopwatch << endl;
+
+    BOOST_CHECK_EQUAL(cmd.retcode(), 0);
+    BOOST_REQUIRE_EQUAL(cmd.stdout().size(), 1);
+    BOOST_CHECK_EQUAL(cmd.stdout().front().size(), 8388608);
+}
@@ -0,0 +1,64 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <iostream>
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Devices/Disk.h"
+#include "storage/Devicegraph.h"
+#include "storage/Storage.h"
+#include "storage/Environment.h"
+#include "storage/Utils/Stopwatch.h"
+#include "testsuite/helpers/TsDisks.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+void
+measure(int n)
+{
+    Environment environment(true, ProbeMode::NONE, TargetMode::DIRECT);
+
+    Storage storage(environment);
+
+    Devicegraph* devicegraph = storage.create_devicegraph("test");
+
+    for (int i = 0; i < n; ++i)
+    {
+	add_disk(devicegraph, i);
+	add_partitions(devicegraph, i);
+    }
+
+    Stopwatch stopwatch;
+
+    // Every search only visits the devices of one disk.
+
+    size_t cnt = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+	const Disk* disk = Disk::find_by_name(devicegraph, disk_name(i));
+	cnt += disk->get_descendants(false).size();
+
+	for (const Device* leaf : disk->get_leaves(false))
+	    cnt += leaf->get_roots(false).size() + leaf->get_ancestors(false).size();
+    }
+
+    cout << devicegraph->num_devices() << " devices, " << cnt << " visited " << stopwatch << endl;
+
+    BOOST_CHECK_EQUAL(cnt, 13 * n + 4 * (1 + 4) * n);
+}
+
+
+BOOST_AUTO_TEST_CASE(performance)
+{
+    // Every disk has a partition table and four partitions each with a
+    // filesystem and a mount point, so 14 devices per disk. Thus about 1000
+    // and 10000 devices.
+
+    measure(72);
+    measure(715);
+}
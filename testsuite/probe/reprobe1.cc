@@ -0,0 +1,59 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Environment.h"
+#include "storage/Storage.h"
+#include "storage/Devicegraph.h"
+#include "storage/Devices/Partition.h"
+#include "storage/Devices/Disk.h"
+#include "storage/Filesystems/BlkFilesystem.h"
+#include "storage/Utils/Logger.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+// Check that reprobe() keeps the sids of unaffected devices and gives
+// new sids to the changed device and its descendants.
+
+BOOST_AUTO_TEST_CASE(reprobe)
+{
+    set_logger(get_stdout_logger());
+
+    Environment environment(true, ProbeMode::READ_MOCKUP, TargetMode::DIRECT);
+    environment.set_mockup_filename("disk-mockup.xml");
+
+    Storage storage(environment);
+    storage.probe();
+
+    const Devicegraph* probed = storage.get_probed();
+
+    sid_t sda = Disk::find_by_name(probed, "/dev/sda")->get_sid();
+    sid_t sdb = Disk::find_by_name(probed, "/dev/sdb")->get_sid();
+    sid_t sda1 = Partition::find_by_name(probed, "/dev/sda1")->get_sid();
+    sid_t sda1_fs = Partition::find_by_name(probed, "/dev/sda1")->get_blk_filesystem()->get_sid();
+    sid_t sda2 = Partition::find_by_name(probed, "/dev/sda2")->get_sid();
+
+    size_t num_devices = probed->num_devices();
+
+    storage.reprobe({ "sda1" });
+
+    probed = storage.get_probed();
+    probed->check();
+
+    BOOST_CHECK_EQUAL(probed->num_devices(), num_devices);
+
+    BOOST_CHECK_EQUAL(Disk::find_by_name(probed, "/dev/sda")->get_sid(), sda);
+    BOOST_CHECK_EQUAL(Disk::find_by_name(probed, "/dev/sdb")->get_sid(), sdb);
+    BOOST_CHECK_EQUAL(Partition::find_by_name(probed, "/dev/sda2")->get_sid(), sda2);
+
+    const Partition* partition = Partition::find_by_name(probed, "/dev/sda1");
+    BOOST_CHECK_NE(partition->get_sid(), sda1);
+    BOOST_CHECK_NE(partition->get_blk_filesystem()->get_sid(), sda1_fs);
+
+    BOOST_CHECK(storage.get_staging()->find_device(sda2));
+    BOOST_CHECK(storage.get_system()->find_device(sda2));
+}
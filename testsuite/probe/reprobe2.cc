@@ -0,0 +1,56 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Environment.h"
+#include "storage/Storage.h"
+#include "storage/Devicegraph.h"
+#include "storage/Devices/Partition.h"
+#include "storage/Devices/Disk.h"
+#include "storage/Utils/Mockup.h"
+#include "storage/Utils/Logger.h"
+#include "storage/Utils/StorageDefines.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+// Check that reprobe() also queries the ancestors of the changed device
+// again, here the partition table of the disk.
+
+BOOST_AUTO_TEST_CASE(reprobe)
+{
+    set_logger(get_stdout_logger());
+
+    Environment environment(true, ProbeMode::READ_MOCKUP, TargetMode::DIRECT);
+    environment.set_mockup_filename("disk-mockup.xml");
+
+    Storage storage(environment);
+    storage.probe();
+
+    const Devicegraph* probed = storage.get_probed();
+
+    sid_t sda = Disk::find_by_name(probed, "/dev/sda")->get_sid();
+
+    BOOST_CHECK_EQUAL(Partition::find_by_name(probed, "/dev/sda1")->get_region().get_length(), 2037760);
+
+    // sda1 was shrunk
+
+    Mockup::set_command(PARTEDBIN " --script --machine '/dev/sda' unit s print", vector<string>({
+	"BYT;",
+	"/dev/sda:16777216s:scsi:512:512:msdos:ATA VBOX HARDDISK:;",
+	"1:2048s:1026047s:1024000s:linux-swap(v1)::type=82;",
+	"2:2039808s:16777215s:14737408s:ext4::boot, type=83;"
+    }));
+
+    storage.reprobe({ "sda1" });
+
+    probed = storage.get_probed();
+    probed->check();
+
+    BOOST_CHECK_EQUAL(Disk::find_by_name(probed, "/dev/sda")->get_sid(), sda);
+    BOOST_CHECK_EQUAL(Partition::find_by_name(probed, "/dev/sda1")->get_region().get_length(), 1024000);
+}
@@ -0,0 +1,55 @@
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE libstorage
+
+#include <boost/test/unit_test.hpp>
+
+#include "storage/Environment.h"
+#include "storage/Storage.h"
+#include "storage/Devicegraph.h"
+#include "storage/Devices/Disk.h"
+#include "storage/Filesystems/BlkFilesystem.h"
+#include "storage/Utils/Logger.h"
+#include "storage/Utils/Mockup.h"
+#include "storage/Utils/StorageDefines.h"
+
+
+using namespace std;
+using namespace storage;
+
+
+// Check that reprobe() keeps the sids of unaffected devices that changed
+// in properties not identifying them, here the label of the filesystem
+// on sdb.
+
+BOOST_AUTO_TEST_CASE(reprobe)
+{
+    set_logger(get_stdout_logger());
+
+    Environment environment(true, ProbeMode::READ_MOCKUP, TargetMode::DIRECT);
+    environment.set_mockup_filename("disk-mockup.xml");
+
+    Storage storage(environment);
+    storage.probe();
+
+    const Devicegraph* probed = storage.get_probed();
+
+    sid_t sdb_fs = Disk::find_by_name(probed, "/dev/sdb")->get_blk_filesystem()->get_sid();
+
+    Mockup::set_command(BLKIDBIN " -c '/dev/null'", vector<string>({
+	"/dev/sda1: UUID=\"86b64dbc-0530-4a4b-bca7-72e2c8b4e317\" TYPE=\"swap\" PARTUUID=\"00032f15-01\" ",
+	"/dev/sda2: UUID=\"9f0f12c5-4d18-494b-b234-7342c953e99a\" TYPE=\"ext4\" PTTYPE=\"dos\" PARTUUID=\"00032f15-02\" ",
+	"/dev/sr0: UUID=\"2014-10-27-14-56-02-00\" LABEL=\"openSUSE-13.2-DVD-x86_640051\" TYPE=\"iso9660\" PTUUID=\"10ce3e4f\" PTTYPE=\"dos\" ",
+	"/dev/sdb: LABEL=\"DATA\" UUID=\"49516005-5d9d-4e00-87b5-516f16de7e6f\" TYPE=\"ext4\""
+    }));
+
+    storage.reprobe({ "sda1" });
+
+    probed = storage.get_probed();
+    probed->check();
+
+    const BlkFilesystem* blk_filesystem = Disk::find_by_name(probed, "/dev/sdb")->get_blk_filesystem();
+
+    BOOST_CHECK_EQUAL(blk_filesystem->get_label(), "DATA");
+    BOOST_CHECK_EQUAL(blk_filesystem->get_sid(), sdb_fs);
+}